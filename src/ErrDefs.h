@@ -56,6 +56,9 @@
 #define LC_NEGATIVE_VALUE 19
 #define LC_NO_DATA        20
 
+// Error codes specific to the StringPool class
+#define SP_POOL_FULL 21
+
 // Define an Error type that can be used for reporting errors in the FAST UI.
 typedef struct error_type {
   int code;
@@ -0,0 +1,224 @@
+// Xgtools
+// Copyright (C) M. P. Ruffoni 2011-2015
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// benchparse : Measures the speed of the writelines row parser
+//
+// Times Line::createLine(), which reads each row in place with a RowTokenizer,
+// against the chained istringstream extraction that it replaced, which is
+// reproduced here as parseWithStream(). Both parse the same rows, and the
+// number of rows parsed per second by each in its fastest pass is reported,
+// along with the speedup.
+//
+// The rows are taken from the writelines line list given at the command line
+// or, if none is given, from a list of BENCH_NUM_ROWS lines generated in
+// memory with Line::getLineString(). Rows holding an overload marker are
+// skipped, as the old parser prints a warning for each. Returns a non-zero
+// code if the speedup is below BENCH_TARGET_SPEEDUP.
+//
+// benchparse is not built by default. Build and run it with "make bench".
+//
+#include "line.h"
+#include "tokenizer.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <sys/time.h>
+
+using namespace::std;
+
+#define BENCH_NUM_ROWS 200000     /* rows generated if no list is given       */
+#define BENCH_HEADER_ROWS 4       /* header rows skipped in a given list      */
+#define BENCH_REPEATS 15          /* times each parser reads every row        */
+#define BENCH_TARGET_SPEEDUP 10.0 /* minimum speedup over istringstream       */
+
+// The line properties read by parseWithStream(), named as in Line
+typedef struct td_StreamLine {
+  int Index, Itn, H;
+  double Wavenumber, Peak, Width, Dmp, EqWidth, EpsTot, EpsEvn, EpsOdd, EpsRan, 
+    Wavelength;
+  char Tags;
+  string Identification;
+} StreamLine;
+
+//------------------------------------------------------------------------------
+// now () : Returns the wall clock time in seconds.
+//
+double now () {
+  struct timeval Time;
+  gettimeofday (&Time, 0);
+  return Time.tv_sec + Time.tv_usec * 1.0e-6;
+}
+
+
+//------------------------------------------------------------------------------
+// parseWithStream (const string &, StreamLine *) : Reads the writelines row at
+// arg1 into arg2 with chained istringstream extraction, exactly as
+// Line::createLine() did before RowTokenizer was introduced. As the rows given
+// contain no overloads, any field that cannot be read is simply thrown.
+//
+void parseWithStream (const string &LineString, StreamLine *L) 
+  throw (const char*) {
+  istringstream iss;
+  iss.str (LineString);
+  char IdCharString [LINE_ID_STRING_LEN];
+  iss >> skipws >> L -> Index; if (iss.fail ()) throw "index";
+  iss >> L -> Wavenumber; if (iss.fail ()) throw "wavenumber";
+  iss >> L -> Peak; if (iss.fail ()) throw "peak height";
+  iss >> L -> Width; if (iss.fail ()) throw "width";
+  iss >> L -> Dmp; if (iss.fail ()) throw "dmp";
+  iss >> L -> EqWidth; if (iss.fail ()) throw "eqwidth";
+  iss >> L -> Itn; if (iss.fail ()) throw "itn";
+  iss >> L -> H; if (iss.fail ()) throw "h";
+  iss >> L -> Tags; if (iss.fail ()) throw "tags";
+  iss >> L -> EpsTot; if (iss.fail ()) throw "epstot";
+  iss >> L -> EpsEvn; if (iss.fail ()) throw "epsevn";
+  iss >> L -> EpsOdd; if (iss.fail ()) throw "epsodd";
+  iss >> L -> EpsRan; if (iss.fail ()) throw "epsran";
+  iss >> ws;
+  iss.get (IdCharString, LINE_ID_STRING_LEN);
+  L -> Identification = IdCharString;
+  iss >> L -> Wavelength; if (iss.fail ()) throw "wavelength";
+  for (int i = L -> Identification.length () - 1; i >= 0; i --) {
+    if (L -> Identification [i] == ' ') L -> Identification.erase (i);
+    else break;
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// generateRows (vector <string> *) : Fills arg1 with BENCH_NUM_ROWS writelines
+// rows of pseudo-random lines, each formatted by Line::getLineString().
+//
+void generateRows (vector <string> *Rows) {
+  const char *Ids [] = { "Fe II 3d6(5D)4s", "Ni I", "Ar II 4s-4p", "Th" };
+  const char Tags [] = { 'G', 'V', 'L', 'H' };
+  Line NewLine;
+  srand (1);
+  for (unsigned int i = 0; i < BENCH_NUM_ROWS; i ++) {
+    double Wavenumber = 10000.0 + 0.15 * i + 0.01 * rand () / RAND_MAX;
+    NewLine.line (i + 1);
+    NewLine.wavenumber (Wavenumber);
+    NewLine.peak (1.0e4 * rand () / RAND_MAX);
+    NewLine.width (20.0 + 80.0 * rand () / RAND_MAX);
+    NewLine.dmp (rand () / (double) RAND_MAX);
+    NewLine.eqwidth (10.0 * rand () / RAND_MAX);
+    NewLine.itn (rand () % 10);
+    NewLine.h (rand () % 3);
+    NewLine.tags (Tags [i % 4]);
+    NewLine.epstot (1.0e-3 * (rand () / (double) RAND_MAX - 0.5));
+    NewLine.epsevn (1.0e-3 * (rand () / (double) RAND_MAX - 0.5));
+    NewLine.epsodd (1.0e-3 * (rand () / (double) RAND_MAX - 0.5));
+    NewLine.epsran (1.0e-3 * (rand () / (double) RAND_MAX - 0.5));
+    NewLine.id (Ids [i % 4]);
+    NewLine.wavelength (1.0e7 / Wavenumber);
+    Rows -> push_back (NewLine.getLineString ());
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// readRows (const char *, vector <string> *) : Fills arg2 with the data rows of
+// the line list at arg1, omitting empty rows and those with overloads. Returns
+// false if the list cannot be read.
+//
+bool readRows (const char *Filename, vector <string> *Rows) {
+  ifstream ListFile (Filename);
+  if (!ListFile.is_open ()) return false;
+  string NextRow;
+  for (unsigned int i = 0; getline (ListFile, NextRow); i ++) {
+    if (i < BENCH_HEADER_ROWS || NextRow.empty ()) continue;
+    if (NextRow.find (XG_OVERLOAD) != string::npos) continue;
+    Rows -> push_back (NextRow);
+  }
+  return true;
+}
+
+
+//==============================================================================
+// main
+//
+int main (int argc, char *argv[]) {
+  vector <string> Rows;
+  if (argc > 1) {
+    if (!readRows (argv[1], &Rows)) {
+      cout << "Error: Cannot read " << argv[1] << "." << endl;
+      return 1;
+    }
+  } else {
+    generateRows (&Rows);
+  }
+  if (Rows.empty ()) {
+    cout << "Error: There are no rows to parse." << endl;
+    return 1;
+  }
+
+  // Parse every row with each parser in turn, BENCH_REPEATS times, keeping the
+  // fastest time for each so that a single slow pass does not decide the
+  // result. The wavenumbers are summed so that neither parse can be optimised
+  // away, and compared to check that both parsers read the same values.
+  StreamLine OldLine;
+  Line NewLine;
+  double OldSum = 0.0, NewSum = 0.0, OldTime = 0.0, NewTime = 0.0;
+  double Start, Elapsed;
+  for (unsigned int r = 0; r < BENCH_REPEATS; r ++) {
+    OldSum = 0.0;
+    Start = now ();
+    try {
+      for (unsigned int i = 0; i < Rows.size (); i ++) {
+        parseWithStream (Rows[i], &OldLine);
+        OldSum += OldLine.Wavenumber;
+      }
+    } catch (const char *Err) {
+      cout << "Error: istringstream parser failed to read the " << Err 
+        << " column." << endl;
+      return 1;
+    }
+    Elapsed = now () - Start;
+    if (r == 0 || Elapsed < OldTime) OldTime = Elapsed;
+    NewSum = 0.0;
+    Start = now ();
+    try {
+      for (unsigned int i = 0; i < Rows.size (); i ++) {
+        NewLine.createLine (Rows[i].data (), Rows[i].data () + Rows[i].size ());
+        NewSum += NewLine.wavenumber ();
+      }
+    } catch (const char *Err) {
+      cout << "Error: RowTokenizer parser failed to read the " << Err 
+        << " column." << endl;
+      return 1;
+    }
+    Elapsed = now () - Start;
+    if (r == 0 || Elapsed < NewTime) NewTime = Elapsed;
+  }
+  if (OldSum != NewSum) {
+    cout << "Error: The two parsers read different wavenumbers." << endl;
+    return 1;
+  }
+
+  double NumParsed = (double) Rows.size ();
+  double Speedup = OldTime / NewTime;
+  printf ("Rows parsed     : %u, best of %d\n", (unsigned int) Rows.size (),
+    BENCH_REPEATS);
+  printf ("istringstream   : %12.0f rows/s\n", NumParsed / OldTime);
+  printf ("RowTokenizer    : %12.0f rows/s\n", NumParsed / NewTime);
+  printf ("Speedup         : %12.1f x (target %.0f x)\n", Speedup, 
+    BENCH_TARGET_SPEEDUP);
+  return Speedup < BENCH_TARGET_SPEEDUP ? 1 : 0;
+}
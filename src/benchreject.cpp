@@ -0,0 +1,201 @@
+// Xgtools
+// Copyright (C) M. P. Ruffoni 2011-2015
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// benchreject : Measures the speed of outlier rejection in ListCal
+//
+// Times ListCal::removeBadLines() on a calibration of BENCH_NUM_LINES common
+// lines, of which about 30% are outliers that are rejected over several rounds
+// of fitting. The line list and standard are generated with Line::
+// getLineString(), and written to the current directory, as ListCal reads its
+// lines from file. Every wavenumber in the standard is shifted in the line list
+// by a correction of BENCH_CORRECTION, plus a small gaussian scatter of
+// BENCH_SCATTER. A fraction BENCH_OUTLIER_RATE of the lines is instead shifted
+// by 10^-7.3 to 10^-6.2, in either direction, which with the parameters below
+// rejects about 30% of the lines once the outliers that lie close to the fitted
+// correction are counted.
+//
+// The whole rejection loop, from the first fit to the round in which no more
+// lines are removed, is repeated BENCH_REPEATS times, and the fastest total
+// time spent in removeBadLines() is reported. Returns a non-zero code if this
+// is above BENCH_TARGET_TIME, which the old implementation, which erased each
+// rejected line from the fit in turn, exceeds several times over.
+//
+// benchreject is not built by default. Build and run it with "make bench".
+//
+#include "listcal.h"
+#include "line.h"
+#include "linecache.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <sys/time.h>
+
+using namespace::std;
+
+#define BENCH_NUM_LINES 100000    /* common lines in the list and standard    */
+#define BENCH_CORRECTION 1.5e-7   /* correction applied to the line list      */
+#define BENCH_SCATTER 1.0e-8      /* std. dev. of dSig/Sig of good lines      */
+#define BENCH_OUTLIER_RATE 0.22   /* fraction of lines shifted as outliers    */
+#define BENCH_REPEATS 5           /* times the rejection loop is run          */
+#define BENCH_TARGET_TIME 25.0    /* maximum time in removeBadLines (), in ms */
+
+// The files to which the generated lists are written
+#define BENCH_LIST_FILE "benchreject_list.txt"
+#define BENCH_STANDARD_FILE "benchreject_std.txt"
+
+// Calibration parameters, as would be given to ftscalibrate
+#define BENCH_DISCRIMINATOR 0.02
+#define BENCH_PEAK_THRESHOLD 50.0
+#define BENCH_DISCARD_LIMIT 2.0
+
+//------------------------------------------------------------------------------
+// now () : Returns the wall clock time in seconds.
+//
+double now () {
+  struct timeval Time;
+  gettimeofday (&Time, 0);
+  return Time.tv_sec + Time.tv_usec * 1.0e-6;
+}
+
+
+//------------------------------------------------------------------------------
+// uniform () : Returns a pseudo-random number in (0, 1).
+//
+double uniform () {
+  return (rand () + 1.0) / (RAND_MAX + 2.0);
+}
+
+
+//------------------------------------------------------------------------------
+// writeList (const char *, const char *, bool) : Writes a writelines line list
+// of BENCH_NUM_LINES lines to the file at arg1. Every line is a copy of the row
+// at arg2 with a new index and wavenumber. If arg3 is false, the wavenumbers
+// are those of the standard. Otherwise they are shifted as described above.
+// Returns false if the file cannot be written.
+//
+bool writeList (const char *Filename, const char *Row, bool Shifted) {
+  ofstream ListFile (Filename);
+  if (!ListFile.is_open ()) return false;
+  ListFile << "  NO WAVENUMBER CORRECTION APPLIED" << endl
+    << "  NO AIR CORRECTION APPLIED" << endl
+    << "  NO INTENSITY CALIBRATION APPLIED" << endl
+    << "  line    wavenumber      peak    width      dmp   eq width   itn   H "
+    << "tags     epstot     epsevn     epsodd     epsran  identification      "
+    << "           wavelength" << endl;
+  Line NewLine;
+  NewLine.createLine (Row);
+  srand (1);
+  for (unsigned int i = 0; i < BENCH_NUM_LINES; i ++) {
+    double Wavenumber = 10000.0 + 0.15 * i;
+    if (Shifted) {
+      double Shift = BENCH_SCATTER * sqrt (-2.0 * log (uniform ()))
+        * cos (2.0 * M_PI * uniform ());
+      if (uniform () < BENCH_OUTLIER_RATE) {
+        Shift = pow (10.0, -7.3 + 1.1 * uniform ());
+        if (uniform () < 0.5) Shift = -Shift;
+      }
+      Wavenumber *= (1.0 + Shift) / (1.0 + BENCH_CORRECTION);
+    }
+    NewLine.line (i + 1);
+    NewLine.wavenumber (Wavenumber);
+    NewLine.wavelength (1.0e7 / Wavenumber);
+    ListFile << NewLine.getLineString () << endl;
+  }
+  return ListFile.good ();
+}
+
+
+//------------------------------------------------------------------------------
+// removeFiles () : Deletes the generated lists, and the line caches written
+// alongside them by ListCal.
+//
+void removeFiles () {
+  remove (BENCH_LIST_FILE);
+  remove (BENCH_STANDARD_FILE);
+  remove (BENCH_LIST_FILE WLC_EXTENSION);
+  remove (BENCH_STANDARD_FILE WLC_EXTENSION);
+}
+
+
+//==============================================================================
+// main
+//
+int main () {
+  if (!writeList (BENCH_LIST_FILE, "     1  15017.705313 7.013e+03    57.50   "
+    "0.8158 5.3115e+00     3   0    G 3.5225e-04 1.0639e-04-3.5002e-04"
+    "-9.4529e-04 Fe II 3d6(5D)4s                665.880692", true)
+    || !writeList (BENCH_STANDARD_FILE, "     1  15017.707231 3.898e+03   "
+    "186.90   0.6759 1.7361e+00     3   0    G 1.9577e-04-6.3919e-04 "
+    "5.5144e-04 1.1287e-04 Fe I                           665.880607", false)) {
+    cout << "Error: Cannot write the line lists to the current directory."
+      << endl;
+    removeFiles ();
+    return 1;
+  }
+
+  // ListCal reports its progress to cout, which is silenced while it runs.
+  // Each repeat starts again from the full set of common lines.
+  ListCal Calibrator;
+  unsigned int NumCommon = 0, NumRemoved = 0, NumRounds = 0;
+  double BestTime = 0.0;
+  cout.setstate (ios::failbit);
+  try {
+    Calibrator.setDiscriminator (BENCH_DISCRIMINATOR);
+    Calibrator.setPeakAmpThreshold (BENCH_PEAK_THRESHOLD);
+    Calibrator.setDiscardLimit (BENCH_DISCARD_LIMIT);
+    Calibrator.loadLists (BENCH_LIST_FILE, BENCH_STANDARD_FILE);
+    for (unsigned int r = 0; r < BENCH_REPEATS; r ++) {
+      Calibrator.findCommonLines (false);
+      Calibrator.findFittedLines (false);
+      NumCommon = Calibrator.getNumFittedLines ();
+      NumRemoved = 0;
+      NumRounds = 0;
+      double Time = 0.0, Start;
+      int Removed;
+      do {
+        Calibrator.findCorrection (false);
+        Start = now ();
+        Removed = Calibrator.removeBadLines (false);
+        Time += now () - Start;
+        NumRemoved += Removed;
+        NumRounds ++;
+      } while (Removed);
+      if (r == 0 || Time < BestTime) BestTime = Time;
+    }
+  } catch (int Err) {
+    cout.clear ();
+    cout << "Error: Calibration failed with error code " << Err << "." << endl;
+    removeFiles ();
+    return 1;
+  }
+  cout.clear ();
+  removeFiles ();
+  if (NumRemoved == 0) {
+    cout << "Error: No lines were rejected from the fit." << endl;
+    return 1;
+  }
+
+  BestTime *= 1.0e3;
+  printf ("Lines fitted    : %u\n", NumCommon);
+  printf ("Lines rejected  : %u (%.1f%%) in %u rounds\n", NumRemoved,
+    100.0 * NumRemoved / NumCommon, NumRounds);
+  printf ("removeBadLines  : %12.1f ms (target %.0f ms)\n", BestTime,
+    BENCH_TARGET_TIME);
+  return BestTime > BENCH_TARGET_TIME ? 1 : 0;
+}
@@ -0,0 +1,232 @@
+// Xgtools
+// Copyright (C) M. P. Ruffoni 2011-2015
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// chunkparse.h
+//==============================================================================
+// parseLineRows() parses the data rows of an XGremlin 'writelines' line list
+// that is already held in memory (see MappedFile), using several threads. The
+// rows are independent of each other, so the data region is split into chunks
+// that each begin and end on a row boundary, and these are parsed in parallel.
+//
+// This is done in two passes. The first counts the rows in each chunk, from
+// which the position of each chunk's first line in the output vector and the
+// row number of its first row can be found. The output vector is then sized
+// once, and the second pass builds each Line in place in its final position.
+// The lines are therefore always returned in file order, and no Line is ever
+// copied once parsed.
+//
+// Each chunk collects the overloads in its rows in its own ParseDiagnostics,
+// so that no output is done and no lock taken while parsing. These are merged
+// in file order once all the chunks have been parsed.
+//
+// In the same way, each chunk creates its lines through its own ChunkStrings.
+// A line class that keeps its strings in a shared pool, such as XgLine, can
+// specialise ChunkStrings to intern them into a pool local to the chunk, and
+// then move them to the shared pool in a single merge once the chunk has been
+// parsed. The general ChunkStrings simply calls createLine(), and has nothing
+// to merge. LineListReader (see linereader.h) also creates its lines through
+// a ChunkStrings, but never merges it. Instead it calls clear() before each
+// row, discarding the strings of the line it read last.
+//
+// LineType may be any class providing wavCorr (double) and createLine (const
+// char*, const char*, ParseDiagnostics*, unsigned int), i.e. either Line or
+// XgLine. As in readLineList(), empty rows are skipped.
+//
+#ifndef CHUNK_PARSE_H
+#define CHUNK_PARSE_H
+
+#include <vector>
+#include <cstring>
+#include "parallel.h"
+#include "diagnostics.h"
+
+// Chunks are never made smaller than this, so that small line lists are
+// parsed in a single chunk without starting any threads.
+#define CHUNK_MIN_SIZE 262144 /* bytes */
+
+// The number of chunks to create per worker thread. Using more chunks than
+// threads evens out the load if some chunks take longer than others.
+#define CHUNKS_PER_THREAD 4
+
+using namespace::std;
+
+// The state of a single chunk of rows.
+typedef struct td_RowChunk {
+  const char *Begin, *End;
+  unsigned int Rows;        // Number of rows in the chunk, including empty rows
+  unsigned int NumLines;    // Number of non-empty rows, i.e. lines to parse
+  unsigned int FirstLine;   // Index in the output vector of the first line
+  unsigned int FailedRow;   // Row within the chunk that failed, or zero
+  unsigned int FailedLine;  // Index in the output vector of the failed line
+  const char *Err;          // The column name thrown by createLine ()
+  ParseDiagnostics Diagnostics;  // Overloads, with rows counted in the chunk
+} RowChunk;
+
+// Creates the lines of a single chunk, and holds any strings read from them
+// until they are merged into the lines' shared storage by merge (vector
+// <LineType> *, unsigned int, unsigned int), which is passed the output vector
+// and the range of lines [arg2, arg3) in it that were created by the chunk, or
+// discarded by clear().
+template <class LineType>
+class ChunkStrings {
+  public:
+    void createLine (LineType &NewLine, const char *Begin, const char *End,
+      ParseDiagnostics *Diagnostics, unsigned int Row) throw (const char*)
+      { NewLine.createLine (Begin, End, Diagnostics, Row); }
+    void merge (vector <LineType> *, unsigned int, unsigned int) {}
+    void clear () {}
+};
+
+// The data shared by all the chunks during a call to parseLineRows(). Each
+// chunk's ChunkStrings is created by the thread that parses it.
+template <class LineType>
+struct RowChunkJob {
+  vector <RowChunk> Chunks;
+  vector <ChunkStrings <LineType> *> Strings;
+  vector <LineType> *Lines;
+  double WavCorr;
+  ~RowChunkJob () {
+    for (unsigned int i = 0; i < Strings.size (); i ++) delete Strings[i];
+  }
+};
+
+
+//------------------------------------------------------------------------------
+// countChunkRows (unsigned int, void *) : First pass task. Counts the total and
+// non-empty rows in a single chunk.
+//
+template <class LineType>
+void countChunkRows (unsigned int ChunkNum, void *JobPtr) {
+  RowChunk &Chunk = ((RowChunkJob <LineType> *) JobPtr) -> Chunks [ChunkNum];
+  const char *Row = Chunk.Begin, *RowEnd;
+  Chunk.Rows = 0;
+  Chunk.NumLines = 0;
+  while (Row < Chunk.End) {
+    RowEnd = (const char *) memchr (Row, '\n', Chunk.End - Row);
+    if (!RowEnd) RowEnd = Chunk.End;
+    Chunk.Rows ++;
+    if (RowEnd != Row) Chunk.NumLines ++;
+    Row = RowEnd + 1;
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// parseChunkRows (unsigned int, void *) : Second pass task. Parses each row of
+// a single chunk into its slot in the output vector. Parsing stops at the first
+// row that cannot be read, which is recorded in the chunk.
+//
+template <class LineType>
+void parseChunkRows (unsigned int ChunkNum, void *JobPtr) {
+  RowChunkJob <LineType> *Job = (RowChunkJob <LineType> *) JobPtr;
+  RowChunk &Chunk = Job -> Chunks [ChunkNum];
+  ChunkStrings <LineType> *Strings = new ChunkStrings <LineType>;
+  Job -> Strings [ChunkNum] = Strings;
+  const char *Row = Chunk.Begin, *RowEnd;
+  unsigned int RowNum = 0, LineNum = Chunk.FirstLine;
+  Chunk.FailedRow = 0;
+  try {
+    while (Row < Chunk.End) {
+      RowEnd = (const char *) memchr (Row, '\n', Chunk.End - Row);
+      if (!RowEnd) RowEnd = Chunk.End;
+      RowNum ++;
+      if (RowEnd != Row) {
+        LineType &NextLine = (*Job -> Lines) [LineNum];
+        NextLine.wavCorr (Job -> WavCorr);
+        Strings -> createLine (NextLine, Row, RowEnd, &Chunk.Diagnostics,
+          RowNum);
+        LineNum ++;
+      }
+      Row = RowEnd + 1;
+    }
+  } catch (const char *Err) {
+    Chunk.FailedRow = RowNum;
+    Chunk.FailedLine = LineNum;
+    Chunk.Err = Err;
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// parseLineRows (const char *, const char *, double, vector <LineType> *,
+// const char **, ParseDiagnostics *) : Parses the rows in [Begin, End) into
+// the vector at arg4, applying the wavenumber correction at arg3 to every line.
+// Returns zero if all the rows were read. Otherwise, the number of the first
+// row that could not be read is returned, counting from 1 at Begin, and the
+// column in which the error occurred is stored at arg5. The vector then holds
+// only the lines that precede the failed row. Any overloads in the rows that
+// were read are added to arg6, with rows also counted from 1 at Begin.
+//
+template <class LineType>
+unsigned int parseLineRows (const char *Begin, const char *End, double WavCorr,
+  vector <LineType> *Lines, const char **Err, ParseDiagnostics *Diagnostics) {
+  RowChunkJob <LineType> Job;
+  RowChunk Chunk;
+  Job.Lines = Lines;
+  Job.WavCorr = WavCorr;
+
+  // Split the data into chunks of roughly equal size, moving the end of each
+  // chunk forward to the end of the row in which it falls.
+  unsigned int NumThreads = numWorkerThreads ();
+  size_t ChunkSize = (End - Begin) / (NumThreads * CHUNKS_PER_THREAD) + 1;
+  if (ChunkSize < CHUNK_MIN_SIZE) ChunkSize = CHUNK_MIN_SIZE;
+  while (Begin < End) {
+    Chunk.Begin = Begin;
+    if ((size_t)(End - Begin) <= ChunkSize) {
+      Chunk.End = End;
+    } else {
+      Chunk.End = (const char *) memchr (Begin + ChunkSize, '\n',
+        End - Begin - ChunkSize);
+      Chunk.End = Chunk.End ? Chunk.End + 1 : End;
+    }
+    Job.Chunks.push_back (Chunk);
+    Begin = Chunk.End;
+  }
+  Job.Strings.resize (Job.Chunks.size (), NULL);
+
+  // Count the lines in each chunk, then size the output vector to hold them
+  // all and note where each chunk's lines should be placed.
+  runParallel (Job.Chunks.size (), countChunkRows <LineType>, &Job, NumThreads);
+  unsigned int NumLines = 0;
+  for (unsigned int i = 0; i < Job.Chunks.size (); i ++) {
+    Job.Chunks[i].FirstLine = NumLines;
+    NumLines += Job.Chunks[i].NumLines;
+  }
+  Lines -> clear ();
+  Lines -> resize (NumLines);
+
+  // Parse the chunks, then check for errors in file order so that the first
+  // bad row in the file is always the one reported, and gather the overloads
+  // and strings in the same order.
+  runParallel (Job.Chunks.size (), parseChunkRows <LineType>, &Job, NumThreads);
+  unsigned int RowCount = 0;
+  for (unsigned int i = 0; i < Job.Chunks.size (); i ++) {
+    Diagnostics -> merge (Job.Chunks[i].Diagnostics, RowCount);
+    Job.Strings[i] -> merge (Lines, Job.Chunks[i].FirstLine,
+      Job.Chunks[i].FailedRow ? Job.Chunks[i].FailedLine
+      : Job.Chunks[i].FirstLine + Job.Chunks[i].NumLines);
+    if (Job.Chunks[i].FailedRow) {
+      Lines -> resize (Job.Chunks[i].FailedLine);
+      *Err = Job.Chunks[i].Err;
+      return RowCount + Job.Chunks[i].FailedRow;
+    }
+    RowCount += Job.Chunks[i].Rows;
+  }
+  return 0;
+}
+
+#endif // CHUNK_PARSE_H
@@ -0,0 +1,129 @@
+// Xgtools
+// Copyright (C) M. P. Ruffoni 2011-2015
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// ParseDiagnostics class (diagnostics.cpp)
+//==============================================================================
+
+#include "diagnostics.h"
+#include "tokenizer.h"
+#include <sstream>
+#include <cstring>
+#include <pthread.h>
+
+bool ParseDiagnostics::Verbose = false;
+
+// Line lists may be read on several threads at once, as when ListCal loads its
+// two lists together, so each report is written whole under a lock.
+static pthread_mutex_t ReportLock = PTHREAD_MUTEX_INITIALIZER;
+
+
+//------------------------------------------------------------------------------
+// count (const char *, unsigned int) : Adds arg2 to the overload count for the
+// column named at arg1. There are only a handful of numeric columns in a line
+// list, so they are simply searched in turn.
+//
+void ParseDiagnostics::count (const char *Column, unsigned int Overloads) {
+  for (unsigned int i = 0; i < Columns.size (); i ++) {
+    if (Columns[i].Column == Column || strcmp (Columns[i].Column, Column) == 0) {
+      Columns[i].Count += Overloads;
+      return;
+    }
+  }
+  ColumnCount NewColumn = { Column, Overloads };
+  Columns.push_back (NewColumn);
+}
+
+
+//------------------------------------------------------------------------------
+// overload (const char *, unsigned int) : Records an overload in the column
+// named at arg1, in row arg2.
+//
+void ParseDiagnostics::overload (const char *Column, unsigned int Row) {
+  count (Column, 1);
+  if (Verbose || Rows.size () < PD_MAX_ROWS) {
+    OverloadRow NewRow = { Column, Row };
+    Rows.push_back (NewRow);
+  }
+  NumOverloads ++;
+}
+
+
+//------------------------------------------------------------------------------
+// merge (const ParseDiagnostics &, unsigned int) : Appends the overloads held
+// by arg1 to those held here, offsetting their rows by arg2. Only as many rows
+// as are still needed are kept.
+//
+void ParseDiagnostics::merge (const ParseDiagnostics &Other, 
+  unsigned int RowOffset) {
+  for (unsigned int i = 0; i < Other.Columns.size (); i ++) {
+    count (Other.Columns[i].Column, Other.Columns[i].Count);
+  }
+  for (unsigned int i = 0; i < Other.Rows.size (); i ++) {
+    if (!Verbose && Rows.size () >= PD_MAX_ROWS) break;
+    OverloadRow NewRow = { Other.Rows[i].Column, Other.Rows[i].Row + RowOffset };
+    Rows.push_back (NewRow);
+  }
+  NumOverloads += Other.NumOverloads;
+}
+
+
+//------------------------------------------------------------------------------
+// clear () : Removes every overload collected so far.
+//
+void ParseDiagnostics::clear () {
+  Columns.clear ();
+  Rows.clear ();
+  NumOverloads = 0;
+}
+
+
+//------------------------------------------------------------------------------
+// report (ostream &, const string &, unsigned int) : Prints a summary of the
+// overloads found in the file at arg2 to the stream at arg1. In verbose mode,
+// each overload is listed in full. Otherwise, the count for each column is
+// given, followed by the first few rows affected. The report is assembled in
+// memory and then written to arg1 at once.
+//
+void ParseDiagnostics::report (ostream &Output, const string &Source,
+  unsigned int RowOffset) const {
+  if (NumOverloads == 0) return;
+  ostringstream Report;
+  if (Verbose) {
+    for (unsigned int i = 0; i < Rows.size (); i ++) {
+      Report << "Warning: " << XG_OVERLOAD << " has been found in the " 
+        << Rows[i].Column << " column on line " << Rows[i].Row + RowOffset
+        << " of " << Source << ". A value of zero has been taken instead.\n";
+    }
+  }
+  Report << "Warning: " << XG_OVERLOAD << " has been found " << NumOverloads
+    << (NumOverloads == 1 ? " time" : " times") << " in " << Source 
+    << ". A value of zero has been taken instead.\n";
+  for (unsigned int i = 0; i < Columns.size (); i ++) {
+    Report << "  " << Columns[i].Column << " column: " << Columns[i].Count 
+      << '\n';
+  }
+  if (!Verbose) {
+    Report << "  Lines affected:";
+    for (unsigned int i = 0; i < Rows.size (); i ++) {
+      Report << (i ? ", " : " ") << Rows[i].Row + RowOffset;
+    }
+    Report << (NumOverloads > Rows.size () ? ", ..." : "") << '\n';
+  }
+  pthread_mutex_lock (&ReportLock);
+  Output << Report.str () << flush;
+  pthread_mutex_unlock (&ReportLock);
+}
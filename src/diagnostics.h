@@ -0,0 +1,103 @@
+// Xgtools
+// Copyright (C) M. P. Ruffoni 2011-2015
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// ParseDiagnostics class (diagnostics.h)
+//==============================================================================
+// Collects the warnings raised while parsing a line list, so that they can be
+// reported once the whole list has been read, rather than printed as each row
+// is parsed. At present the only such warning is for XGremlin's overload
+// marker, XG_OVERLOAD, which RowTokenizer reads as zero.
+//
+// overload() records a single overload, and does no output, so it may be called
+// freely from within a parsing loop. The collector counts the overloads found
+// in each column, and keeps the row numbers of the first PD_MAX_ROWS of them.
+// report() then prints a single summary of everything collected. If verbose
+// output has been turned on with the static verbose (bool) function, every row
+// number is kept, and the summary lists each overload on its own row, as the
+// warnings did when they were printed during parsing.
+//
+// A ParseDiagnostics is not shared between threads. When a line list is parsed
+// on several threads (see chunkparse.h), each chunk of rows has its own
+// collector, and these are merged in file order with merge() once parsing is
+// complete. The rows reported are therefore always the first in the file.
+//
+#ifndef PARSE_DIAGNOSTICS_H
+#define PARSE_DIAGNOSTICS_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+// The number of overloaded rows listed in a summary, unless verbose
+#define PD_MAX_ROWS 10
+
+using namespace::std;
+
+class ParseDiagnostics {
+  public:
+    ParseDiagnostics () { NumOverloads = 0; }
+    ~ParseDiagnostics () {}
+
+    // Records an overload in the column named at arg1, in row arg2. The name
+    // must remain valid for the lifetime of the collector, as the column names
+    // passed by RowTokenizer, which are string literals, always do.
+    void overload (const char *Column, unsigned int Row);
+
+    // Adds the overloads collected by arg1 to those held here, adding arg2 to
+    // each of its row numbers.
+    void merge (const ParseDiagnostics &Other, unsigned int RowOffset = 0);
+
+    // Removes every overload collected so far.
+    void clear ();
+
+    // Returns the number of overloads collected
+    unsigned int overloads () const { return NumOverloads; }
+
+    // Prints a summary of the overloads found in the file named at arg2 to the
+    // stream at arg1, adding arg3 to each row number. Nothing is printed if
+    // there were no overloads.
+    void report (ostream &Output, const string &Source,
+      unsigned int RowOffset = 0) const;
+
+    // Turns verbose reporting on or off for every collector.
+    static void verbose (bool NewVerbose) { Verbose = NewVerbose; }
+    static bool verbose () { return Verbose; }
+
+  private:
+    typedef struct td_ColumnCount {
+      const char *Column;
+      unsigned int Count;
+    } ColumnCount;
+
+    typedef struct td_OverloadRow {
+      const char *Column;
+      unsigned int Row;
+    } OverloadRow;
+
+    // The overload count for each column, in the order that the columns were
+    // first seen, and the first rows found, in file order.
+    vector <ColumnCount> Columns;
+    vector <OverloadRow> Rows;
+    unsigned int NumOverloads;
+
+    static bool Verbose;
+
+    // Adds arg2 overloads to the count for the column at arg1
+    void count (const char *Column, unsigned int Overloads);
+};
+
+#endif // PARSE_DIAGNOSTICS_H
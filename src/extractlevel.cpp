@@ -22,6 +22,7 @@
 #include <sstream>
 #include <string>
 #include <cmath>
+#include "mappedfile.h"
 
 using namespace::std;
 
@@ -94,13 +95,15 @@ int main (int argc, char* argv[])
     iss >> LevelEnergy;
   }
 
-  ifstream FullKuruczList (argv [KURUCZ_INPUT]);
+  // Open the Kurucz input list. This may be gzip or zstd compressed.
+  MappedFile FullKuruczList (argv [KURUCZ_INPUT]);
 
-  if (FullKuruczList.is_open ()) 
+  if (FullKuruczList.isOpen ()) 
   {
     istringstream iss;
     ostringstream oss;
     string NextLine;
+    const char *Row, *RowEnd, *NextRow = FullKuruczList.begin ();
     oss << fixed << right;
     double LowerLevel, UpperLevel, Temp;
     double *TargetLevel;
@@ -111,40 +114,39 @@ int main (int argc, char* argv[])
       showHelp ();
       return 1;
     }
-    while (!FullKuruczList.eof ()) 
+    while (NextRow < FullKuruczList.end ()) 
     {
-      if (FullKuruczList.peek () != '\0')
+      Row = NextRow;
+      NextRow = FullKuruczList.nextRow (Row, &RowEnd);
+      NextLine.assign (Row, RowEnd);
+      iss.clear (); iss.str (NextLine.substr (24, 12));
+      iss >> LowerLevel;
+      iss.clear (); iss.str (NextLine.substr (52, 12));
+      iss >> UpperLevel;
+      if (IgnoreMinus && (LowerLevel < 0 || UpperLevel < 0)) {
+        LowerLevel = abs(LowerLevel);
+        UpperLevel = abs(UpperLevel);
+        oss.str (""); oss.clear ();
+        oss << NextLine.substr (0, 24);
+        oss.precision (3); oss.width (12);
+        oss << LowerLevel;
+        oss << NextLine.substr (36, 16);
+        oss.precision (3); oss.width (12);
+        oss << UpperLevel;
+        oss << NextLine.substr (64);
+        NextLine = oss.str ();
+      }
+          
+      if (abs(LowerLevel) > abs(UpperLevel))
       {
-        getline (FullKuruczList, NextLine);
-        iss.clear (); iss.str (NextLine.substr (24, 12));
-        iss >> LowerLevel;
-        iss.clear (); iss.str (NextLine.substr (52, 12));
-        iss >> UpperLevel;
-        if (IgnoreMinus && (LowerLevel < 0 || UpperLevel < 0)) {
-          LowerLevel = abs(LowerLevel);
-          UpperLevel = abs(UpperLevel);
-          oss.str (""); oss.clear ();
-          oss << NextLine.substr (0, 24);
-          oss.precision (3); oss.width (12);
-          oss << LowerLevel;
-          oss << NextLine.substr (36, 16);
-          oss.precision (3); oss.width (12);
-          oss << UpperLevel;
-          oss << NextLine.substr (64);
-          NextLine = oss.str ();
-        }
-            
-        if (abs(LowerLevel) > abs(UpperLevel))
-        {
-          Temp = LowerLevel;
-          LowerLevel = UpperLevel;
-          UpperLevel = Temp;
-        }
-        
-        if (abs(abs(*TargetLevel) - LevelEnergy) < DISCRIMINATOR) {
-          if (!(RemovePredicted && (LowerLevel < 0 || UpperLevel < 0))) {
-            cout << NextLine << endl;
-          }
+        Temp = LowerLevel;
+        LowerLevel = UpperLevel;
+        UpperLevel = Temp;
+      }
+      
+      if (abs(abs(*TargetLevel) - LevelEnergy) < DISCRIMINATOR) {
+        if (!(RemovePredicted && (LowerLevel < 0 || UpperLevel < 0))) {
+          cout << NextLine << endl;
         }
       }
     }
@@ -27,7 +27,8 @@
 //
 // This program is essentially just a re-implementation of the older DIFFLIST
 // code with the addition of a Levenberg-Marquardt fitting algorithm from the
-// GNU Scientific Library.
+// GNU Scientific Library. As the fit is linear in epsilon, it is now solved in
+// closed form by default, but the GSL solver can still be used with -g.
 //
 // In order to be included in the fitting, each line in the uncalibrated list
 // must have a S/N ratio of at least SNR_{min}, and be no further than D cm^-1
@@ -56,10 +57,42 @@
 // using the equation given by Brault in Mikrochim. Acta (Wien) 3 pp.215 (1987),
 // and secondly, by using the standard deviation in the fit residuals.
 //
+// With the -r option, the error in \epsilon is also estimated without relying
+// on the fit covariance, by refitting \epsilon to bootstrap resamples of the
+// fitted lines, and to jackknife samples that each leave out one line. The
+// bootstrap percentile intervals and the jackknife standard error are saved
+// in the header of the calibration results file.
+//
+// With the -f option, the uncalibrated list is followed as XGremlin writes it.
+// Each time new lines are appended, they alone are read and the calibration
+// repeated, so that the results are kept up to date during an acquisition.
+//
+// The fit residuals are then plotted with Gnuplot, on screen until the user
+// presses enter, and then to Calibration.ps. For unattended runs, -s or -p
+// saves the plot straight to an SVG or PNG file instead, with no wait, and -n
+// skips the plot altogether.
+//
+// With the -w option, the discriminator, S/N limit and discard limit may each
+// be given as a range of values, and the list is calibrated with every
+// combination of them, to show how sensitive the calibration is to each. Both
+// lists are read once, and shared by all the calibrations, which run in
+// parallel.
+//
+// With the -b option, many line lists are calibrated against one standard list
+// in a single run. The standard list is read once, and the lists are then
+// calibrated in parallel, each by its own ListCal, with the results tabulated
+// in a single summary file. A batch in which two lists would save their
+// results under the same name is rejected before any list is calibrated.
+//
 #include "listcal.h"
+#include "parallel.h"
 #include <iostream>
+#include <fstream>
 #include <string>
 #include <sstream>
+#include <vector>
+#include <map>
+#include <cstdio>
 
 #define LC_VERSION "1.0"
 
@@ -74,11 +107,427 @@
 #define ARG_POINT_SPACING 6 /* 6th arg is the spacing between data points in K*/
 #define ARG_OUT_FILE_1 7    /* 7th arg is the output for the calibrated list  */
 #define ARG_OUT_FILE_2 3    /* as above, but for the second argument form     */
+#define ARG_VERBOSE "-v"    /* option to list every overload in the line lists */
+#define ARG_FOLLOW "-f"     /* option to recalibrate as lines are appended    */
+#define ARG_GSL "-g"        /* option to fit with the GSL non-linear solver   */
+#define ARG_BATCH "-b"      /* option to calibrate every list named in <list> */
+#define ARG_RESAMPLE "-r"   /* option to resample the fitted lines            */
+#define ARG_NO_PLOT "-n"    /* option to skip the plot                        */
+#define ARG_SVG "-s"        /* option to save the plot as SVG, not show it    */
+#define ARG_PNG "-p"        /* option to save the plot as PNG, not show it    */
+#define ARG_SWEEP "-w"      /* option to sweep the calibration parameters     */
+#define RANGE_SEPARATOR ':' /* separates the parts of a range, first:last:step */
+
+// The number of bootstrap resamples made with the -r option
+#define NUM_RESAMPLES 10000
 
 // Error codes
 #define LC_NO_ERROR     0
 #define LC_SYNTAX_ERROR 1
 
+// A line list to be calibrated in batch mode by calibrateListTask(): the list,
+// the name under which its results are saved, the ListCal holding the shared
+// standard list and calibration settings, and the results of the calibration.
+// Err holds the error code thrown while calibrating the list, if any.
+typedef struct td_BatchJob {
+  string Filename;
+  string OutputName;
+  ListCal *Reference;
+  double WaveCorrection;
+  double WaveCorrectionError;
+  double DiffMean;
+  double DiffStdDev;
+  unsigned int NumFitted;
+  unsigned int NumDiscarded;
+  unsigned int NumRounds;
+  int Err;
+} BatchJob;
+
+// One point in the grid of calibration parameters evaluated by sweepTask():
+// the parameters, the ListCal holding the shared line lists and the other
+// settings, and the results of the calibration. Err holds the error code
+// thrown while calibrating with these parameters, if any.
+typedef struct td_SweepPoint {
+  double Discriminator;
+  double PeakAmpThreshold;
+  double DiscardLimit;
+  ListCal *Reference;
+  double WaveCorrection;
+  double WaveCorrectionError;
+  double ReducedChiSq;
+  unsigned int NumFitted;
+  unsigned int NumDiscarded;
+  int Err;
+} SweepPoint;
+
+//------------------------------------------------------------------------------
+// calibrate (ListCal &, string) : Calibrates the loaded line lists, outputs the
+// results to the user, and saves the calibrated list to the file at arg2.
+//
+void calibrate (ListCal &ListFitter, string OutputName) throw (int) {
+
+  // Find all the lines common to both lists. From these common lines,
+  // discard any of amplitude less than DEF_PEAK_THRESHOLD
+  ListFitter.findCommonLines (false);
+  ListFitter.findFittedLines (true);
+
+  // Now fit the uncalibrated list to the standard lines. If any lines remain
+  // beyond DEF_DISCARD_LIMIT standard deviations of the mean after fitting,
+  // remove them and refine the fit. Stop when all the fitted lines are within
+  // DEF_DISCARD_LIMIT standard deviations of the mean.
+  unsigned int NumLinesRemoved, NumRounds = 0;
+  do {
+  
+    // Do the fitting here
+    ListFitter.findCorrection ();
+    NumRounds ++;
+    
+    // Remove any bad lines and output the results to the user
+    if ((NumLinesRemoved = ListFitter.removeBadLines (true))) {
+      cout << "Removed " << NumLinesRemoved << " bad line" << flush;
+      if (NumLinesRemoved > 1) cout << "s" << flush;
+      cout << " from the fit." << endl;
+      cout << endl << "Refining the calibration..." << endl;
+    } else {
+      cout << "All lines are within " << DEF_DISCARD_LIMIT << " standard deviations of the mean." << endl;
+      cout << endl << "Calibration complete after " << NumRounds << " round" 
+        << (NumRounds > 1 ? "s" : "") << " of fitting." << endl;
+    }
+    
+    // Continue until no lines are removed by ListFitter.removeBadLines()
+  } while (NumLinesRemoved);
+  
+  // The calibration is now complete. Output the results to the user, after
+  // estimating the uncertainty by resampling if this was requested.
+  cout << endl;
+  if (ListFitter.getNumResamples ()) {
+    ListFitter.resampleCorrection (true);
+    cout << endl;
+  }
+  cout << "Residual Mean dSig/Sig   : " << ListFitter.getDiffMean () / LC_DATA_SCALE << endl;
+  cout << "Residual StdDev dSig/Sig : " << ListFitter.getDiffStdDev () / LC_DATA_SCALE << endl;
+  cout << "Residual StdErr dSig/Sig : " << ListFitter.getDiffStdErr () / LC_DATA_SCALE << endl;
+  cout << "--------------------------------------------------" << endl;
+  cout << "Optimal dSig/Sig : " << ListFitter.getWaveCorrection () << " +/- "
+    << ListFitter.getWaveCorrectionError() << endl;
+  cout << "--------------------------------------------------" << endl;
+  cout << endl;
+  ListFitter.saveLineList (OutputName.c_str());
+}
+
+
+//------------------------------------------------------------------------------
+// calibrateListTask (unsigned int, void *) : A ParallelTask that calibrates one
+// of the line lists in the BatchJob array at arg2, against the standard list
+// shared by the job's Reference, and saves the results. Each task has its own
+// ListCal, so any number may run at once. Nothing is printed, except errors.
+//
+void calibrateListTask (unsigned int TaskNum, void *Data) {
+  BatchJob *Job = (BatchJob*) Data + TaskNum;
+  ListCal ListFitter;
+  try {
+    ListFitter.setDiscriminator (Job -> Reference -> getDiscriminator ());
+    ListFitter.setPeakAmpThreshold (Job -> Reference -> getPeakAmpThreshold ());
+    ListFitter.setDiscardLimit (Job -> Reference -> getDiscardLimit ());
+    ListFitter.setPointSpacing (Job -> Reference -> getPointSpacing ());
+    ListFitter.setFitMethod (Job -> Reference -> getFitMethod ());
+    ListFitter.setNumResamples (Job -> Reference -> getNumResamples ());
+    ListFitter.setResampleSeed (Job -> Reference -> getResampleSeed ());
+    ListFitter.shareStandardList (*Job -> Reference);
+    ListFitter.loadLineList (Job -> Filename.c_str ());
+    ListFitter.findCommonLines (false);
+    ListFitter.findFittedLines (false);
+    Job -> NumRounds = 0;
+    do {
+      ListFitter.findCorrection (false);
+      Job -> NumRounds ++;
+    } while (ListFitter.removeBadLines (false));
+    ListFitter.resampleCorrection (false);
+    int Err = ListFitter.saveLineList (Job -> OutputName.c_str ());
+    if (Err != LC_NO_ERROR) throw int (Err);
+  } catch (int Err) {
+    Job -> Err = Err;
+    return;
+  }
+  Job -> WaveCorrection = ListFitter.getWaveCorrection ();
+  Job -> WaveCorrectionError = ListFitter.getWaveCorrectionError ();
+  Job -> DiffMean = ListFitter.getDiffMean ();
+  Job -> DiffStdDev = ListFitter.getDiffStdDev ();
+  Job -> NumFitted = ListFitter.getNumFittedLines ();
+  Job -> NumDiscarded = ListFitter.getNumDiscardedLines ();
+}
+
+
+//------------------------------------------------------------------------------
+// batchOutputName (string) : Returns the name under which the results for the
+// line list at arg1 are saved in batch mode. This is the list's own name, with
+// any extension removed, so that the results are saved alongside the list.
+//
+string batchOutputName (string Filename) {
+  size_t Dot = Filename.find_last_of ('.');
+  size_t Slash = Filename.find_last_of ('/');
+  if (Dot != string::npos && Dot > 0 && (Slash == string::npos || Dot > Slash + 1)) {
+    Filename.erase (Dot);
+  }
+  return Filename;
+}
+
+
+//------------------------------------------------------------------------------
+// saveBatchSummary (const vector <BatchJob> &, ListCal &, string, const char*) :
+// Writes a table of the results of every job at arg1 to the file at arg3,
+// after a header recording the standard list at arg4 and the settings held by
+// arg2. Returns LC_FILE_OPEN_ERROR if the file cannot be created.
+//
+int saveBatchSummary (const vector <BatchJob> &Jobs, ListCal &Reference,
+  string Filename, const char *StandardFilename) {
+  FILE *SummaryFile = fopen (Filename.c_str (), "w");
+  if (!SummaryFile) return LC_FILE_OPEN_ERROR;
+  fprintf (SummaryFile, "# Line lists calibrated against standards in %s\n", 
+    StandardFilename);
+  fprintf (SummaryFile, "# Discriminator / K : %f\n", Reference.getDiscriminator ());
+  fprintf (SummaryFile, "# Peak Amp Threshold: %f\n", Reference.getPeakAmpThreshold ());
+  fprintf (SummaryFile, "# Discard Limit     : %f\n", Reference.getDiscardLimit ()); 
+  fprintf (SummaryFile, "# Point Spacing     : %f\n#\n", Reference.getPointSpacing ());
+  fprintf (SummaryFile, "# Correction     Error          Mean Residual  Residual StdDev  Fitted  Discarded  Rounds  List\n");
+  for (unsigned int i = 0; i < Jobs.size (); i ++) {
+    if (Jobs[i].Err != LC_NO_ERROR) {
+      fprintf (SummaryFile, "# Calibration failed with error %d: %s\n", 
+        Jobs[i].Err, Jobs[i].Filename.c_str ());
+      continue;
+    }
+    fprintf (SummaryFile, "%14.6e  %13.6e  %13.6e  %15.6e  %6u  %9u  %6u  %s\n",
+      Jobs[i].WaveCorrection, Jobs[i].WaveCorrectionError, 
+      Jobs[i].DiffMean / LC_DATA_SCALE, Jobs[i].DiffStdDev / LC_DATA_SCALE,
+      Jobs[i].NumFitted, Jobs[i].NumDiscarded, Jobs[i].NumRounds, 
+      Jobs[i].Filename.c_str ());
+  }
+  fclose (SummaryFile);
+  return LC_NO_ERROR;
+}
+
+
+//------------------------------------------------------------------------------
+// calibrateBatch (ListCal &, const char *, const char *, string) : Calibrates
+// every line list named in the file at arg2, one per row, against the standard
+// list at arg3, with the settings held by arg1. The standard list is read into
+// arg1 once and shared by every calibration, and the lists are calibrated
+// several at once. A summary of the results is printed and saved to the file
+// at arg4. Returns the error code of the first list that could not be
+// calibrated, if any.
+//
+int calibrateBatch (ListCal &Reference, const char *BatchFilename,
+  const char *StandardFilename, string SummaryName) {
+  vector <BatchJob> Jobs;
+  BatchJob NewJob;
+  string NextRow;
+  
+  // Read the names of the line lists to calibrate. Blank rows, and rows
+  // starting with '#', are ignored.
+  ifstream BatchFile (BatchFilename);
+  if (!BatchFile.is_open ()) {
+    cout << "Error: Cannot read " << BatchFilename 
+      << ". Check the file exists and has read permissions." << endl;
+    return LC_FILE_OPEN_ERROR;
+  }
+  NewJob.Reference = &Reference;
+  NewJob.NumFitted = NewJob.NumDiscarded = NewJob.NumRounds = 0;
+  NewJob.Err = LC_NO_ERROR;
+  while (getline (BatchFile, NextRow)) {
+    size_t Begin = NextRow.find_first_not_of (" \t\r");
+    if (Begin == string::npos || NextRow[Begin] == '#') continue;
+    size_t End = NextRow.find_last_not_of (" \t\r");
+    NewJob.Filename = NextRow.substr (Begin, End - Begin + 1);
+    NewJob.OutputName = batchOutputName (NewJob.Filename);
+    Jobs.push_back (NewJob);
+  }
+  if (Jobs.empty ()) {
+    cout << "Error: No line lists are named in " << BatchFilename << "." << endl;
+    return LC_NO_DATA;
+  }
+
+  // The lists are calibrated at the same time, so two lists whose results would
+  // be saved under the same name, such as a.asc and a.cln, or one list named
+  // twice, would overwrite each other's output as it is written.
+  map <string, unsigned int> OutputNames;
+  for (unsigned int i = 0; i < Jobs.size (); i ++) {
+    map <string, unsigned int>::iterator Found 
+      = OutputNames.find (Jobs[i].OutputName);
+    if (Found != OutputNames.end ()) {
+      cout << "Error: The results for " << Jobs[Found -> second].Filename
+        << " and " << Jobs[i].Filename << " would both be saved as "
+        << Jobs[i].OutputName << ". Rename one of them, or calibrate them in"
+        << " separate batches." << endl;
+      return LC_SYNTAX_ERROR;
+    }
+    OutputNames [Jobs[i].OutputName] = i;
+  }
+
+  // Load the standard list once, then calibrate all the lists against it
+  try {
+    Reference.loadStandardList (StandardFilename);
+  } catch (int Err) {
+    return Err;
+  }
+  cout << endl << "Calibrating " << Jobs.size () << " line list" 
+    << (Jobs.size () > 1 ? "s" : "") << "..." << endl;
+  runParallel (Jobs.size (), calibrateListTask, &Jobs[0]);
+
+  // Report the results in the order the lists were given
+  int FirstErr = LC_NO_ERROR;
+  cout << endl;
+  for (unsigned int i = 0; i < Jobs.size (); i ++) {
+    if (Jobs[i].Err == LC_NO_ERROR) {
+      cout << Jobs[i].Filename << ": dSig/Sig = " << Jobs[i].WaveCorrection 
+        << " +/- " << Jobs[i].WaveCorrectionError << " (" << Jobs[i].NumFitted
+        << " lines fitted, " << Jobs[i].NumDiscarded << " discarded)" << endl;
+    } else {
+      cout << Jobs[i].Filename << ": calibration FAILED (error " 
+        << Jobs[i].Err << ")" << endl;
+      if (FirstErr == LC_NO_ERROR) FirstErr = Jobs[i].Err;
+    }
+  }
+  if (saveBatchSummary (Jobs, Reference, SummaryName, StandardFilename) 
+    != LC_NO_ERROR) {
+    cout << "Error: Cannot open " << SummaryName 
+      << " for output. Summary writing ABORTED." << endl;
+    if (FirstErr == LC_NO_ERROR) FirstErr = LC_FILE_OPEN_ERROR;
+  }
+  return FirstErr;
+}
+
+
+//------------------------------------------------------------------------------
+// parseRange (string, vector <double> *) : Reads the values of a swept
+// parameter from arg1 into arg2. arg1 is either a single value, or a range
+// given as first:last:step, which gives every value from first to last in
+// increments of step. Returns false if arg1 is not a valid range.
+//
+bool parseRange (string Arg, vector <double> *Values) {
+  double First, Last, Step;
+  char Separator1, Separator2;
+  Values -> clear ();
+  if (Arg.find (RANGE_SEPARATOR) == string::npos) {
+    Values -> push_back (atof (Arg.c_str ()));
+    return true;
+  }
+  istringstream iss (Arg);
+  if (!(iss >> First >> Separator1 >> Last >> Separator2 >> Step) 
+    || Separator1 != RANGE_SEPARATOR || Separator2 != RANGE_SEPARATOR 
+    || Step <= 0.0 || Last < First) {
+    return false;
+  }
+  for (unsigned int i = 0; First + i * Step <= Last + Step * 1.0e-6; i ++) {
+    Values -> push_back (First + i * Step);
+  }
+  return true;
+}
+
+
+//------------------------------------------------------------------------------
+// sweepTask (unsigned int, void *) : A ParallelTask that calibrates the line
+// list shared by one of the points in the SweepPoint array at arg2, using that
+// point's parameters, and stores the results. Nothing is saved or printed.
+//
+void sweepTask (unsigned int TaskNum, void *Data) {
+  SweepPoint *Point = (SweepPoint*) Data + TaskNum;
+  ListCal ListFitter;
+  try {
+    ListFitter.setDiscriminator (Point -> Discriminator);
+    ListFitter.setPeakAmpThreshold (Point -> PeakAmpThreshold);
+    ListFitter.setDiscardLimit (Point -> DiscardLimit);
+    ListFitter.setPointSpacing (Point -> Reference -> getPointSpacing ());
+    ListFitter.setFitMethod (Point -> Reference -> getFitMethod ());
+    ListFitter.shareLineList (*Point -> Reference);
+    ListFitter.shareStandardList (*Point -> Reference);
+    ListFitter.findCommonLines (false);
+    ListFitter.findFittedLines (false);
+    do {
+      ListFitter.findCorrection (false);
+    } while (ListFitter.removeBadLines (false));
+  } catch (int Err) {
+    Point -> Err = Err;
+    return;
+  }
+  Point -> WaveCorrection = ListFitter.getWaveCorrection ();
+  Point -> WaveCorrectionError = ListFitter.getWaveCorrectionError ();
+  Point -> ReducedChiSq = ListFitter.getReducedChiSq ();
+  Point -> NumFitted = ListFitter.getNumFittedLines ();
+  Point -> NumDiscarded = ListFitter.getNumDiscardedLines ();
+}
+
+
+//------------------------------------------------------------------------------
+// sweepParameters (ListCal &, const char *, const char *, vector <double> [3],
+// string) : Calibrates the line list at arg2 against the standard list at arg3
+// with every combination of the discriminators, peak amplitude thresholds and
+// discard limits in arg4, which are given in that order. Both lists are read
+// into arg1 once, and shared by every calibration, which otherwise uses the
+// settings held by arg1. The grid points are evaluated in parallel, and a table
+// of the results is saved to the file at arg5. Returns an error code only if
+// the lists cannot be read or the table cannot be saved.
+//
+int sweepParameters (ListCal &Reference, const char *ListFilename,
+  const char *StandardFilename, vector <double> Ranges [3], string TableName) {
+  vector <SweepPoint> Points;
+  SweepPoint NewPoint;
+  
+  // Build the grid of parameters to evaluate
+  NewPoint.Reference = &Reference;
+  NewPoint.NumFitted = NewPoint.NumDiscarded = 0;
+  NewPoint.Err = LC_NO_ERROR;
+  for (unsigned int i = 0; i < Ranges[0].size (); i ++) {
+    for (unsigned int j = 0; j < Ranges[1].size (); j ++) {
+      for (unsigned int k = 0; k < Ranges[2].size (); k ++) {
+        NewPoint.Discriminator = Ranges[0][i];
+        NewPoint.PeakAmpThreshold = Ranges[1][j];
+        NewPoint.DiscardLimit = Ranges[2][k];
+        Points.push_back (NewPoint);
+      }
+    }
+  }
+
+  // Load both lists once, then calibrate with every set of parameters
+  try {
+    Reference.loadLists (ListFilename, StandardFilename);
+  } catch (int Err) {
+    return Err;
+  }
+  cout << endl << "Evaluating " << Points.size () << " sets of calibration "
+    << "parameters..." << endl;
+  runParallel (Points.size (), sweepTask, &Points[0]);
+
+  // Save the results in the order of the grid
+  FILE *TableFile = fopen (TableName.c_str (), "w");
+  if (!TableFile) {
+    cout << "Error: Cannot open " << TableName 
+      << " for output. Sweep results ABORTED." << endl;
+    return LC_FILE_OPEN_ERROR;
+  }
+  fprintf (TableFile, "# Calibration of %s against standards in %s\n", 
+    ListFilename, StandardFilename);
+  fprintf (TableFile, "# Point Spacing     : %f\n#\n", Reference.getPointSpacing ());
+  fprintf (TableFile, "# Discriminator  Peak Amp Threshold  Discard Limit  Correction     Error          Reduced chi^2  Fitted  Discarded\n");
+  unsigned int NumFailed = 0;
+  for (unsigned int i = 0; i < Points.size (); i ++) {
+    fprintf (TableFile, "%15f  %18f  %13f  ", Points[i].Discriminator, 
+      Points[i].PeakAmpThreshold, Points[i].DiscardLimit);
+    if (Points[i].Err != LC_NO_ERROR) {
+      fprintf (TableFile, "# Calibration failed with error %d\n", Points[i].Err);
+      NumFailed ++;
+      continue;
+    }
+    fprintf (TableFile, "%13.6e  %13.6e  %13.6e  %6u  %9u\n",
+      Points[i].WaveCorrection, Points[i].WaveCorrectionError, 
+      Points[i].ReducedChiSq, Points[i].NumFitted, Points[i].NumDiscarded);
+  }
+  fclose (TableFile);
+  cout << "Calibrated with " << Points.size () - NumFailed << " of " 
+    << Points.size () << " sets of parameters." << endl;
+  return LC_NO_ERROR;
+}
+
+
 //==============================================================================
 // main
 //
@@ -89,13 +538,74 @@ int main (int argc, char *argv[]) {
   
   cout << "FTS Line List Calibrator v" << LC_VERSION << " (built " << __DATE__ << ")" << endl << endl;
 
+  // Remove any options from the command line, so that the remaining arguments
+  // can be counted to find which form of the syntax has been used.
+  vector <char*> Args;
+  bool Follow = false, Batch = false, Sweep = false, Plot = true;
+  string PlotExtension = "";
+  for (int i = 0; i < argc; i ++) {
+    if (string (argv[i]) == ARG_VERBOSE) {
+      ParseDiagnostics::verbose (true);
+    } else if (string (argv[i]) == ARG_FOLLOW) {
+      Follow = true;
+    } else if (string (argv[i]) == ARG_GSL) {
+      ListFitter.setFitMethod (FIT_METHOD_GSL);
+    } else if (string (argv[i]) == ARG_BATCH) {
+      Batch = true;
+    } else if (string (argv[i]) == ARG_RESAMPLE) {
+      ListFitter.setNumResamples (NUM_RESAMPLES);
+    } else if (string (argv[i]) == ARG_SWEEP) {
+      Sweep = true;
+    } else if (string (argv[i]) == ARG_NO_PLOT) {
+      Plot = false;
+    } else if (string (argv[i]) == ARG_SVG) {
+      PlotExtension = ".svg";
+    } else if (string (argv[i]) == ARG_PNG) {
+      PlotExtension = LC_PLOT_PNG_EXTENSION;
+    } else {
+      Args.push_back (argv[i]);
+    }
+  }
+  argc = Args.size ();
+  argv = &Args[0];
   
   // Check the command line syntax. Output a help message if it's incorrect
   // and abort, returning a non-zero error code
-  if (argc != REQ_NUM_ARGS_1 && argc != REQ_NUM_ARGS_2) {
+  // In sweep mode, the parameters to be swept must be given, and each may be a
+  // range of values.
+  vector <double> Ranges [3];
+  bool BadSweep = Sweep && (Follow || Batch || argc != REQ_NUM_ARGS_1 
+    || !parseRange (argv[ARG_DISCRIMINATOR], &Ranges[0])
+    || !parseRange (argv[ARG_THRESHOLD], &Ranges[1])
+    || !parseRange (argv[ARG_DISCARD_LIMIT], &Ranges[2]));
+  if ((argc != REQ_NUM_ARGS_1 && argc != REQ_NUM_ARGS_2) || (Follow && Batch)
+    || BadSweep) {
     cout << "ftscalibrate: Calibrates the wavenumbers of lines saved in an XGremlin ASCII (writelines) line list" << endl;
     cout << "---------------------------------------------------------------------------------------------------" << endl;
-    cout << "Syntax: ftscalibrate <list> <standards> [<discriminator> <min S/N> <discard limit> <spacing>] <output file>" << endl << endl;
+    cout << "Syntax: ftscalibrate [-v] [-f | -b | -w] [-g] [-r] [-n | -s | -p] <list> <standards> [<discriminator> <min S/N> <discard limit> <spacing>] <output file>" << endl << endl;
+    cout << "-v             : List every overloaded (**********) value found in <list> and <standards>, rather than" << endl;
+    cout << "                 a summary." << endl;
+    cout << "-f             : Follow <list> as it is written, recalibrating and saving <output file> each time new" << endl;
+    cout << "                 lines are appended to it, until interrupted. No plot is shown." << endl;
+    cout << "-g             : Fit the wavenumber correction with the GSL Levenberg-Marquardt solver, rather than by" << endl;
+    cout << "                 linear least squares." << endl;
+    cout << "-r             : Also estimate the uncertainty in the correction from " << NUM_RESAMPLES << " bootstrap resamples," << endl;
+    cout << "                 and a jackknife, of the fitted lines. The percentile intervals found are saved in" << endl;
+    cout << "                 the header of the .cal file." << endl;
+    cout << "-w             : Sweep mode. Each of <discriminator>, <min S/N> and <discard limit> may be given as a" << endl;
+    cout << "                 range, first:last:step. <list> is calibrated, in parallel, with every combination of" << endl;
+    cout << "                 the values given, and a table of the correction, its error, the reduced chi^2 and" << endl;
+    cout << "                 the number of lines fitted for each is saved to <output file>. The lists are read" << endl;
+    cout << "                 only once. Nothing else is saved, and no plot is shown." << endl;
+    cout << "-n             : Do not plot the fit residuals." << endl;
+    cout << "-s             : Save the plot of the fit residuals to <output file>.svg, rather than showing it on" << endl;
+    cout << "                 screen and waiting for the user. Nothing else is written to the current directory." << endl;
+    cout << "-p             : As -s, but save the plot to <output file>.png." << endl;
+    cout << "-b             : Batch mode. <list> names a file listing one line list per row, each of which is" << endl;
+    cout << "                 calibrated against <standards>, several at once. The results for each list are saved" << endl;
+    cout << "                 alongside it, named as the list without its extension, and a summary of every" << endl;
+    cout << "                 correction is saved to <output file>. No plot is shown. Lists whose results would be" << endl;
+    cout << "                 saved under the same name are rejected." << endl;
     cout << "<list>         : An XGremlin ASCII line list containing the lines to be calibrated (written with writelines)." << endl;
     cout << "<standards>    : An XGremlin ASCII line list to act as the calibration standard (also in writelines format)." << endl;
     cout << "<discriminator>: The maximum allowed wavenumber difference (in cm^-1) when searching for common lines in" << endl;
@@ -120,64 +630,77 @@ int main (int argc, char *argv[]) {
     OutputName = argv[ARG_OUT_FILE_2];
   }
   
+  // In sweep mode, output the ranges given rather than the parameters
+  if (Sweep) {
+    cout << "Line list to be calibrated: " << argv[ARG_LIST_FILE] << endl;
+    cout << "Calibration standard list : " << argv[ARG_STD_FILE] << endl;
+    cout << "Discriminators            : " << argv[ARG_DISCRIMINATOR] << endl;
+    cout << "Minimum line amplitudes   : " << argv[ARG_THRESHOLD] << endl;
+    cout << "Discard limits            : " << argv[ARG_DISCARD_LIMIT] << endl;
+    cout << "Sweep results saved to    : " << OutputName << endl;
+    return sweepParameters (ListFitter, argv[ARG_LIST_FILE], argv[ARG_STD_FILE],
+      Ranges, OutputName);
+  }
+
   // Output the calibration parameters before continuing  
-  cout << "Line list to be calibrated: " << argv[ARG_LIST_FILE] << endl;
+  if (Batch) {
+    cout << "Line lists to calibrate   : " << argv[ARG_LIST_FILE] << endl;
+  } else {
+    cout << "Line list to be calibrated: " << argv[ARG_LIST_FILE] << endl;
+  }
   cout << "Calibration standard list : " << argv[ARG_STD_FILE] << endl;
   cout << "Discriminator             : " << ListFitter.getDiscriminator() << endl;
   cout << "Minimum line amplitude    : " << ListFitter.getPeakAmpThreshold() << endl;
   cout << "Discard beyond x Std Dev  : " << ListFitter.getDiscardLimit() << endl;  
+  if (Batch) {
+    cout << "Summary saved to          : " << OutputName << endl;
+    return calibrateBatch (ListFitter, argv[ARG_LIST_FILE], argv[ARG_STD_FILE],
+      OutputName);
+  }
   cout << "Calibrated list saved to  : " << OutputName << endl;
 
-  // Prepare the calibration. Pass the list files to the ListCal object
-  // and find all the lines common to both lists. From these common lines,
-  // discard any of amplitude less than DEF_PEAK_THRESHOLD
+  // Load the lists and calibrate. When following the list, recalibrate
+  // whenever new lines are appended to it, until the program is interrupted.
+  // Until enough lines have been appended to calibrate, this is not an error.
   cout << endl << "Starting calibration..." << endl;
   try {
-    ListFitter.loadLineList (argv[ARG_LIST_FILE]);
-    ListFitter.loadStandardList (argv[ARG_STD_FILE]);
-    ListFitter.findCommonLines (false);
-    ListFitter.findFittedLines (true);
+    if (Follow) {
+      ListFitter.loadStandardList (argv[ARG_STD_FILE]);
+      ListFitter.followLineList (argv[ARG_LIST_FILE]);
+    } else {
+      ListFitter.loadLists (argv[ARG_LIST_FILE], argv[ARG_STD_FILE]);
+    }
+    while (true) {
+      try {
+        calibrate (ListFitter, OutputName);
+      } catch (int Err) {
+        if (!Follow || (Err != LC_NO_DATA && Err != LC_NO_OVERLAP)) throw;
+      }
+      if (!Follow) break;
+      cout << endl << "Waiting for new lines in " << argv[ARG_LIST_FILE] 
+        << "..." << endl;
+      unsigned int NumLinesAdded;
+      while ((NumLinesAdded = ListFitter.updateLineList ()) == 0);
+      cout << "Read " << NumLinesAdded << " new line" 
+        << (NumLinesAdded > 1 ? "s" : "") << ". Refining the calibration..."
+        << endl;
+    }
   } catch (int Err) {
     return Err;
   }
-
-  // Now fit the uncalibrated list to the standard lines. If any lines remain
-  // beyond DEF_DISCARD_LIMIT standard deviations of the mean after fitting,
-  // remove them and refine the fit. Stop when all the fitted lines are within
-  // DEF_DISCARD_LIMIT standard deviations of the mean.
-  unsigned int NumLinesRemoved;
-  do {
   
-    // Do the fitting here
-    ListFitter.findCorrection ();
-    
-    // Remove any bad lines and output the results to the user
-    if ((NumLinesRemoved = ListFitter.removeBadLines (true))) {
-      cout << "Removed " << NumLinesRemoved << " bad line" << flush;
-      if (NumLinesRemoved > 1) cout << "s" << flush;
-      cout << " from the fit." << endl;
-      cout << endl << "Refining the calibration..." << endl;
+  // Finally, plot the results with GNUPlot, either on screen or, without
+  // waiting for the user, straight to a file
+  if (!Plot) return LC_NO_ERROR;
+  try {
+    if (PlotExtension.empty ()) {
+      ListFitter.plotDifferences ();
     } else {
-      cout << "All lines are within " << DEF_DISCARD_LIMIT << " standard deviations of the mean." << endl;
-      cout << endl << "Calibration complete." << endl;
+      ListFitter.plotDifferences ((OutputName + PlotExtension).c_str ());
+      cout << "Plot saved to " << OutputName + PlotExtension << endl;
     }
-    
-    // Continue until no lines are removed by ListFitter.removeBadLines()
-  } while (NumLinesRemoved);
-  
-  // The calibration is now complete. Output the results to the user
-  cout << endl;
-  cout << "Residual Mean dSig/Sig   : " << ListFitter.getDiffMean () / LC_DATA_SCALE << endl;
-  cout << "Residual StdDev dSig/Sig : " << ListFitter.getDiffStdDev () / LC_DATA_SCALE << endl;
-  cout << "Residual StdErr dSig/Sig : " << ListFitter.getDiffStdErr () / LC_DATA_SCALE << endl;
-  cout << "--------------------------------------------------" << endl;
-  cout << "Optimal dSig/Sig : " << ListFitter.getWaveCorrection () << " +/- "
-    << ListFitter.getWaveCorrectionError() << endl;
-  cout << "--------------------------------------------------" << endl;
-  cout << endl;
-  ListFitter.saveLineList (OutputName.c_str());
-  
-  // Finally, plot the results with GNUPlot
-  ListFitter.plotDifferences ();
+  } catch (int Err) {
+    return Err;
+  }
   return LC_NO_ERROR;
 }
@@ -24,6 +24,8 @@
 #include <vector>
 #include "kzline.h"
 #include "xgline.h"
+#include "mappedfile.h"
+#include "wavelength.h"
 
 using namespace::std;
 
@@ -40,6 +42,7 @@ using namespace::std;
 #define ARG_MAX_MODE3 3
 #define ARG_MIN_MODE4 5
 #define ARG_MAX_MODE4 6
+#define ARG_TABLE_FLAG "-w"
 
 #define ERR_NO_ERROR           0
 #define ERR_INPUT_READ_ERROR   1
@@ -57,7 +60,8 @@ void showHelp () {
   cout << endl;
   cout << "generatesyn : Generates an XGremlin SYN file from a Kurucz line list" << endl;
   cout << "----------------------------------------------------------------------" << endl;
-  cout << "Syntax : generate_syn <kurucz in> [<peak> <width> <damping>] [<min sigma> <max sigma>] <syn out>" << endl << endl;
+  cout << "Syntax : generate_syn [-w <table out>] <kurucz in> [<peak> <width> <damping>] [<min sigma> <max sigma>] <syn out>" << endl << endl;
+  cout << "<table out> : If given, a table of the vacuum and air wavelengths of each line" << endl;
   cout << "<kurucz in> : A Kurucz line list from which to generate a SYN file" << endl;
   cout << "<peak>      : Line peak height written to the SYN file (default " << DEF_LINE_PEAK << ")" << endl;
   cout << "<width>     : Line width written to the SYN file (default " << DEF_LINE_WIDTH << ")" << endl;
@@ -75,11 +79,28 @@ int main (int argc, char* argv[])
   ostringstream oss;
   istringstream iss;
   string StrNextLine;
+  const char *Row, *RowEnd, *NextRow;
   KzLine NextLine;
   float Peak = DEF_LINE_PEAK, Width = DEF_LINE_WIDTH, Damping = DEF_LINE_DMP;
   float MinX = 0, MaxX = 0;
   vector <string> Lines;
   vector <string> Args;
+  vector <string> Ids;
+  vector <double> Sigmas;
+  
+  // Remove the wavelength table option, if given, so that the remaining
+  // arguments can be counted to find the mode as before.
+  const char *TableFilename = NULL;
+  vector <char*> Argv;
+  for (int i = 0; i < argc; i ++) {
+    if (string (argv[i]) == ARG_TABLE_FLAG && i + 1 < argc) {
+      TableFilename = argv[++i];
+    } else {
+      Argv.push_back (argv[i]);
+    }
+  }
+  argc = Argv.size ();
+  argv = &Argv[0];
   
   for (unsigned int i = 1; i < argc; i ++) {
     Args.push_back (argv[i]);
@@ -106,9 +127,9 @@ int main (int argc, char* argv[])
     return ERR_SYNTAX_ERROR;
   }
   
-  // Open the Kurucz input list
-  ifstream FullKuruczList (argv [KURUCZ_INPUT]);
-  if (!FullKuruczList.is_open ())
+  // Open the Kurucz input list. This may be gzip or zstd compressed.
+  MappedFile FullKuruczList (argv [KURUCZ_INPUT]);
+  if (!FullKuruczList.isOpen ())
   {
     cout << "Error Opening " << argv [KURUCZ_INPUT] << endl << 
       "Check the file exists and that you have permission to read it" << endl;
@@ -124,31 +145,30 @@ int main (int argc, char* argv[])
   }
 
   // Read the Kurucz list and write each line out in SYN format to the SYN file. 
-  while (!FullKuruczList.eof ())
+  NextRow = FullKuruczList.begin ();
+  while (NextRow < FullKuruczList.end ())
   {
-    if (FullKuruczList.peek () != '\0')
-    {
-      getline (FullKuruczList, StrNextLine);
-      NextLine.readLine (StrNextLine);
-      
-      oss.str ("");
-      oss.width (15);
-      if (NextLine.eUpper () > NextLine.eLower ()) {
-        oss << left << NextLine.configUpper () << "  ";
-      } else {
-        oss << left << NextLine.configLower () << "  ";
-      }
-      oss << fixed << right;
-      oss.width (11); oss.precision (5); oss << NextLine.sigma ();
-      oss.width (10); oss.precision (4); oss << Width;
-      oss.width (9);  oss.precision (2); oss << Peak;
-      oss.width (8);  oss.precision (4); oss << Damping;
-      if (argc == REQ_NUM_ARGS_MODE1 || argc == REQ_NUM_ARGS_MODE2) {
-        Lines.push_back (oss.str ());
-      } else {
-        if (NextLine.sigma () >= MinX && NextLine.sigma () <= MaxX) {
-          Lines.push_back (oss.str ());
-        }
+    Row = NextRow;
+    NextRow = FullKuruczList.nextRow (Row, &RowEnd);
+    StrNextLine.assign (Row, RowEnd);
+    NextLine.readLine (StrNextLine);
+    
+    oss.str ("");
+    oss.width (15);
+    const string &Config = NextLine.eUpper () > NextLine.eLower () ?
+      NextLine.configUpper () : NextLine.configLower ();
+    oss << left << Config << "  ";
+    oss << fixed << right;
+    oss.width (11); oss.precision (5); oss << NextLine.sigma ();
+    oss.width (10); oss.precision (4); oss << Width;
+    oss.width (9);  oss.precision (2); oss << Peak;
+    oss.width (8);  oss.precision (4); oss << Damping;
+    if (argc == REQ_NUM_ARGS_MODE1 || argc == REQ_NUM_ARGS_MODE2 ||
+      (NextLine.sigma () >= MinX && NextLine.sigma () <= MaxX)) {
+      Lines.push_back (oss.str ());
+      if (TableFilename) {
+        Ids.push_back (Config);
+        Sigmas.push_back (NextLine.sigma ());
       }
     }
   }
@@ -159,6 +179,21 @@ int main (int argc, char* argv[])
     SynOutput << Lines [i] << endl;
   }
   
+  // Write the wavelength table, if requested, in the same order
+  if (TableFilename) {
+    ofstream TableOutput (TableFilename);
+    WavelengthTable Table (TableOutput);
+    bool Written = TableOutput.is_open ();
+    for (int i = Sigmas.size () - 1; i >= 0 && Written; i --) {
+      Written = Table.add (Ids[i], Sigmas[i]);
+    }
+    if (!Written || !Table.flush ()) {
+      cout << "Error Opening " << TableFilename << endl << 
+        "Check that you have permission to write to this location" << endl;
+      return ERR_OUTPUT_WRITE_ERROR;
+    }
+  }
+  
   // Tidy up and quit
   FullKuruczList.close ();
   SynOutput.close ();
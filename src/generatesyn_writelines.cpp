@@ -23,18 +23,22 @@
 #include <cmath>
 #include <vector>
 #include "xgline.h"
+#include "linereader.h"
+#include "wavelength.h"
 
 using namespace::std;
 
 #define REQ_NUM_ARGS 3
+#define OPT_NUM_ARGS 4
 #define WRITELINES_INPUT 1
 #define SYN_OUTPUT 2
+#define TABLE_OUTPUT 3
+#define ARG_VERBOSE "-v"
 
 #define ERR_NO_ERROR           0
 #define ERR_INPUT_READ_ERROR   1
 #define ERR_OUTPUT_WRITE_ERROR 2
 
-#define HEADER_SIZE 4
 
 //------------------------------------------------------------------------------
 // showHelp () : Prints syntax help message to the standard output.
@@ -43,9 +47,11 @@ void showHelp () {
   cout << endl;
   cout << "generatesyn_writelines : Generates an XGremlin SYN file from writelines output" << endl;
   cout << "----------------------------------------------------------------------------------" << endl;
-  cout << "Syntax : generate_syn <kurucz in> <syn out>" << endl << endl;
+  cout << "Syntax : generate_syn [-v] <kurucz in> <syn out> [<table out>]" << endl << endl;
+  cout << "-v           : List every overloaded (**********) value in <writelines in>" << endl;
   cout << "<writelines in>  : An XGremlin 'writelines' list from which to generate a SYN file" << endl;
-  cout << "<syn out>    : The SYN file generated from <writelines in>" << endl << endl;
+  cout << "<syn out>    : The SYN file generated from <writelines in>" << endl;
+  cout << "<table out>  : If given, a table of the vacuum and air wavelengths of each line" << endl << endl;
 }
 
 //------------------------------------------------------------------------------
@@ -53,40 +59,69 @@ void showHelp () {
 //
 int main (int argc, char* argv[]) 
 {
-  // Check the user's command line input
-  if (argc != REQ_NUM_ARGS) {
+  // Remove the verbose option, if given, then check the user's command line
+  vector <char*> Args;
+  for (int i = 0; i < argc; i ++) {
+    if (string (argv[i]) == ARG_VERBOSE) {
+      ParseDiagnostics::verbose (true);
+    } else {
+      Args.push_back (argv[i]);
+    }
+  }
+  argc = Args.size ();
+  argv = &Args[0];
+  if (argc != REQ_NUM_ARGS && argc != OPT_NUM_ARGS) {
     cout << "Syntax error: Too few arguments were specified" << endl;
     showHelp ();
     return 1;
   }  
   
-  ifstream WriteLinesList (argv [WRITELINES_INPUT]);
+  LineListReader <XgLine> WriteLinesList;
   ofstream SynOutput (argv [SYN_OUTPUT]);
-  string StrNextLine;
   XgLine NextLine;
-  vector <string> Lines;
-  if (WriteLinesList.is_open ())
+  
+  // Open the wavelength table, if one was requested
+  ofstream TableOutput;
+  if (argc == OPT_NUM_ARGS) {
+    TableOutput.open (argv [TABLE_OUTPUT]);
+    if (!TableOutput.is_open ()) {
+      cout << "Error: Unable to write to " << argv [TABLE_OUTPUT] << endl;
+      return ERR_OUTPUT_WRITE_ERROR;
+    }
+  }
+  WavelengthTable Table (TableOutput);
+  
+  if (WriteLinesList.open (argv [WRITELINES_INPUT]))
   {
     if (SynOutput.is_open ()) 
     {
-      // Discard the writelines file header
-      for (unsigned int i = 0; i < HEADER_SIZE; i ++) {
-        getline (WriteLinesList, StrNextLine);
-      }
-      
-      // Read the line data from the writelines file
-      while (!WriteLinesList.eof ()) 
-      {
-        if (WriteLinesList.peek () != '\0')
+      // Convert the writelines file one line at a time. The header has already
+      // been discarded by the reader, and empty rows are skipped.
+      OutputBuffer SynBuffer (SynOutput);
+      try {
+        while (WriteLinesList.next (&NextLine))
         {
-          getline (WriteLinesList, StrNextLine);
-          NextLine.createLine (StrNextLine);
-          Lines.push_back (NextLine.getLineSynString ());
+          NextLine.writeLineSynString (SynBuffer);
+          if (argc == OPT_NUM_ARGS) Table.add (NextLine.id (), 
+            NextLine.wavenumber ());
         }
+      } catch (const char *Err) {
+        SynBuffer.flush ();
+        WriteLinesList.diagnostics ().report (cout, argv [WRITELINES_INPUT]);
+        cout << "Error reading " << Err << " from line " << WriteLinesList.row ()
+          << " in " << argv [WRITELINES_INPUT] << endl;
+        return ERR_INPUT_READ_ERROR;
+      }
+      SynBuffer.flush ();
+      WriteLinesList.diagnostics ().report (cout, argv [WRITELINES_INPUT]);
+      if (WriteLinesList.failed ()) {
+        cout << "Error: Unable to read " << argv [WRITELINES_INPUT] 
+          << " beyond line " << WriteLinesList.row () << endl;
+        return ERR_INPUT_READ_ERROR;
       }
-      for (unsigned int i = 0; i < Lines.size (); i ++)
-      {
-        SynOutput << Lines [i] << endl;
+      if (argc == OPT_NUM_ARGS && !Table.flush ()) {
+        cout << "Error: Unable to write to " << argv [TABLE_OUTPUT] << endl;
+        return ERR_OUTPUT_WRITE_ERROR;
       }
     }
     else 
@@ -100,7 +135,6 @@ int main (int argc, char* argv[])
     cout << "Error: Unable to open " << argv [WRITELINES_INPUT] << endl;
     return ERR_INPUT_READ_ERROR;
   }
-  WriteLinesList.close ();
   SynOutput.close ();
   return ERR_NO_ERROR;
 }
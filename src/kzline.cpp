@@ -22,7 +22,10 @@
 #include <iostream>
 #include <cstdio>
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
 #include "kzline.h"
+#include "recordlayout.h"
 
 //------------------------------------------------------------------------------
 // Default constructor. Initialises all class variables.
@@ -85,76 +88,94 @@ void KzLine::initClass () {
 }
 
 
+//------------------------------------------------------------------------------
+// readField (const char *, int, T *) : Reads the numeric field of width arg2
+// starting at arg1 into arg3. Returns false, setting arg3 to zero, if the field
+// is blank or holds anything other than a single number.
+//
+static bool readField (const char *Field, int Width, double *Value) {
+  char Text [KZ_RECORD_LENGTH + 1], *End;
+  memcpy (Text, Field, Width);
+  Text [Width] = '\0';
+  *Value = strtod (Text, &End);
+  bool Read = End != Text;
+  while (*End == ' ') End ++;
+  if (!Read || *End != '\0') {
+    *Value = 0.0;
+    return false;
+  }
+  return true;
+}
+
+static bool readField (const char *Field, int Width, int *Value) {
+  char Text [KZ_RECORD_LENGTH + 1], *End;
+  memcpy (Text, Field, Width);
+  Text [Width] = '\0';
+  *Value = strtol (Text, &End, 10);
+  bool Read = End != Text;
+  while (*End == ' ') End ++;
+  if (!Read || *End != '\0') {
+    *Value = 0;
+    return false;
+  }
+  return true;
+}
+
+
+// Field macros for KURUCZ_LAYOUT (see recordlayout.h). The _READ macros read
+// each field from the record at Field, then advance Field past it. The _FORMAT
+// and _ARG macros give the lineString() format and arguments, and the _WIDTH
+// macros give the total record width, which is checked against
+// KZ_RECORD_LENGTH when compiling.
+#define KZ_INT_READ(Member, Width, Required)                                   \
+  if (!readField (Field, Width, &Member) && Required) {                        \
+    throw Error (LC_FILE_READ_ERROR);                                          \
+  }                                                                            \
+  Field += Width;
+#define KZ_REAL_READ(Member, Width, Precision, Required)                       \
+  KZ_INT_READ (Member, Width, Required)
+#define KZ_CHAR_READ(Member) Member = *Field ++;
+#define KZ_TEXT_READ(Member, Width) Member.assign (Field, Width); Field += Width;
+#define KZ_GAP_READ(Text) Field += sizeof (Text) - 1;
+
+#define KZ_INT_FORMAT(Member, Width, Required) "%" #Width "d"
+#define KZ_REAL_FORMAT(Member, Width, Precision, Required)                     \
+  "%" #Width "." #Precision "f"
+#define KZ_CHAR_FORMAT(Member) "%c"
+#define KZ_TEXT_FORMAT(Member, Width) "%" #Width "s"
+
+#define KZ_INT_ARG(Member, Width, Required) , Member
+#define KZ_REAL_ARG(Member, Width, Precision, Required) , Member
+#define KZ_CHAR_ARG(Member) , Member
+#define KZ_TEXT_ARG(Member, Width) , Member.c_str ()
+
+#define KZ_INT_WIDTH(Member, Width, Required) + Width
+#define KZ_REAL_WIDTH(Member, Width, Precision, Required) + Width
+#define KZ_CHAR_WIDTH(Member) + 1
+#define KZ_TEXT_WIDTH(Member, Width) + Width
+#define KZ_GAP_WIDTH(Text) + (sizeof (Text) - 1)
+
+// Fails to compile if the fields of KURUCZ_LAYOUT do not fill a whole record.
+typedef char KzLayoutWidthCheck [(0 KURUCZ_LAYOUT (KZ_INT_WIDTH, KZ_REAL_WIDTH,
+  KZ_CHAR_WIDTH, KZ_TEXT_WIDTH, KZ_GAP_WIDTH) == KZ_RECORD_LENGTH) ? 1 : -1];
+
+
 //------------------------------------------------------------------------------
 // readLine (string) : Given a full line of text from a Kurucz line list, this
 // function will extract all the line properties and store them in the Line
-// object.
+// object. Each field is read from its own columns, in the order given by
+// KURUCZ_LAYOUT. Optional numeric fields that are blank are set to zero.
 //
 void KzLine::readLine (string LineInfoIn) throw (Error) {
-  istringstream iss;
-  string LineInfo = LineInfoIn;
+  const char *Field = LineInfoIn.data ();
 
   // First, check that LineInfoIn is of the correct length
   if (LineInfoIn.size () != KZ_RECORD_LENGTH) {
     throw Error (LC_FILE_READ_ERROR);
   }
 
-  // First, explictly read the character fields
-  try {
-    ConfigLower = LineInfo.substr (42, 10);
-    ConfigUpper = LineInfo.substr (70, 10);
-    Ref = LineInfo.substr (98, 4);
-    HfNoteLower = LineInfo[136];
-    HfNoteUpper = LineInfo[139];
-    TagCode = LineInfo.substr (141, 3);
-  } catch (out_of_range& Err) {
-    throw Error (LC_FILE_READ_ERROR);
-  }
-  
-  // Then remove all the character fields to leave only numeric ones
-  LineInfo.erase (141, 3);
-  LineInfo.erase (LineInfo.begin() + 139);
-  LineInfo.erase (LineInfo.begin() + 136);
-  LineInfo.erase (LineInfo.begin() + 134);
-  LineInfo.erase (98, 4);
-  LineInfo.erase (70, 10);
-  LineInfo.erase (42, 10);
-  
-  // Now read the numeric fields from a string stream
-  iss.str (LineInfo);
-  iss >> Lambda >> Loggf >> Code >> ELower >> JLower >> EUpper >> JUpper
-    >> GammaRad >> GammaStark >> GammaWaals >> NlteLower >> NlteUpper
-    >> Isotope >> HfStrength >> Isotope2 >> IsotopeAbundance;
-  if (!iss.good ()) {
-    throw Error (LC_FILE_READ_ERROR);
-  }
-  
-  // Some of the fields are left blank if not used. Attempt to read them one at
-  // a time. If any are blank, just skip them and set the property to 0 
-  iss.str (LineInfoIn.substr (124, 5)); iss >> HfShiftLower;
-  if (iss.fail ()) { HfShiftLower = 0; iss.clear (); }
-  iss.str (LineInfoIn.substr (129, 5)); iss >> HfShiftUpper;
-  if (iss.fail ()) { HfShiftUpper = 0; iss.clear (); }
-  iss.str (LineInfoIn.substr (135, 1)); iss >> HfFLower;
-  if (iss.fail ()) { HfFLower = 0; iss.clear (); }
-  iss.str (LineInfoIn.substr (138, 1)); iss >> HfFUpper;
-  if (iss.fail ()) { HfFUpper = 0; iss.clear (); }
-  iss.str (LineInfoIn.substr (140, 1)); iss >> StrengthClass;
-  if (iss.fail ()) { StrengthClass = 0; iss.clear (); }
-  
-  // The next two parameters should always be present
-  iss.str (LineInfoIn.substr (144)); 
-  iss >> LandeGLower >> LandeGUpper;
-  if (iss.fail ()) {
-    throw Error (LC_FILE_READ_ERROR);
-  }
-  
-  // The final parameter may or may not be present
-  try {
-    iss.str (LineInfoIn.substr (154, 6)); iss >> IsotopeShift;
-  } catch (out_of_range& Err) {
-    IsotopeShift = 0;
-  }
+  KURUCZ_LAYOUT (KZ_INT_READ, KZ_REAL_READ, KZ_CHAR_READ, KZ_TEXT_READ,
+    KZ_GAP_READ)
 }
 
 
@@ -164,18 +185,12 @@ void KzLine::readLine (string LineInfoIn) throw (Error) {
 // and returns the result.
 //
 std::string KzLine::lineString () {
-  std::string rtnString;
-  char str [171];
-  sprintf (str, "%11.4f%7.3f%6.2f%12.3f%5.1f %10s%12.3f%5.1f %10s%6.2f%6.2f%6.2f%4s%2i%2i%3i%6.3f%3i%6.3f%5i%5i %i%c %i%c%i%3s%5i%5i%6i",
-    Lambda, Loggf, Code, ELower, JLower, ConfigLower.c_str(), EUpper, JUpper, 
-    ConfigUpper.c_str(), GammaRad, GammaStark, GammaWaals, Ref.c_str(), NlteLower, 
-    NlteUpper, Isotope, HfStrength, Isotope2, IsotopeAbundance, 
-    HfShiftLower, HfShiftUpper, HfFLower, HfNoteLower, HfFUpper, 
-    HfNoteUpper, StrengthClass, TagCode.c_str(), LandeGLower, LandeGUpper, 
-    IsotopeShift);
-  
-  rtnString = str;
-  return rtnString;
+  char str [2 * KZ_RECORD_LENGTH];
+  snprintf (str, sizeof (str), KURUCZ_LAYOUT (KZ_INT_FORMAT, KZ_REAL_FORMAT,
+    KZ_CHAR_FORMAT, KZ_TEXT_FORMAT, LAYOUT_GAP_FORMAT) 
+    KURUCZ_LAYOUT (KZ_INT_ARG, KZ_REAL_ARG, KZ_CHAR_ARG, KZ_TEXT_ARG,
+    LAYOUT_NONE));
+  return std::string (str);
 }
 
 
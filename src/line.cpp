@@ -16,11 +16,35 @@
 //
 
 #include "line.h"
+#include "tokenizer.h"
+#include "recordlayout.h"
 #include <iostream>
 #include <sstream>
 #include <cmath>
 
-#define XG_OVERLOAD "**********"
+// Field macros for the writelines tags, which are a single character in a
+// Line, and the identification, which is held in a character array and is not
+// required. See recordlayout.h.
+#define LINE_TAG_FORMAT(Column, Member, Get, Width, Read) "%" #Width "c"
+#define LINE_TAG_ARG(Column, Member, Get, Width, Read) , Get ()
+#define LINE_TAG_READ(Column, Member, Get, Width, Read)                        \
+  Member = Row.getChar (#Column);
+#define LINE_TEXT_ARG(Column, Member, Spec, Read) , Member
+#define LINE_TEXT_READ(Column, Member, Spec, Read)                             \
+  Row.getFixed (Member, Read, true);
+
+// printf() formats and arguments for the output strings, generated from the
+// 'syn' and 'writelines' layouts in recordlayout.h.
+#define LINE_SYN_FORMAT                                                        \
+  SYN_LAYOUT (LAYOUT_REAL_FORMAT, LAYOUT_TEXT_FORMAT, LAYOUT_GAP_FORMAT)
+#define LINE_SYN_ARGS                                                          \
+  SYN_LAYOUT (LAYOUT_REAL_ARG, LINE_TEXT_ARG, LAYOUT_NONE)
+#define LINE_STRING_FORMAT                                                     \
+  WRITELINES_LAYOUT (LAYOUT_INT_FORMAT, LAYOUT_REAL_FORMAT, LINE_TAG_FORMAT,   \
+    LAYOUT_TEXT_FORMAT, LAYOUT_GAP_FORMAT)
+#define LINE_STRING_ARGS                                                       \
+  WRITELINES_LAYOUT (LAYOUT_INT_ARG, LAYOUT_REAL_ARG, LINE_TAG_ARG,            \
+    LINE_TEXT_ARG, LAYOUT_NONE)
 
 //------------------------------------------------------------------------------
 // Default Line constructor : Sets all the line properties to default values
@@ -28,7 +52,7 @@
 Line::Line () {
   Index = 0; Itn = 0; H = 0; Wavenumber = 0.0; Peak = 0.0;  Width = 0.0; 
   Dmp = 0.0; EqWidth = 0.0; EpsTot = 0.0; EpsEvn = 0.0; EpsOdd = 0.0; 
-  EpsRan = 0.0; Wavelength = 0.0; Tags = '.'; Identification = "";
+  EpsRan = 0.0; Wavelength = 0.0; Tags = '.'; Identification[0] = '\0';
   WavenumberCorrection = 0.0; AirCorrection = 0.0; IntensityCalibration = 0.0;
 }
 
@@ -48,91 +72,46 @@ Line::Line (string LineData, double NewWaveCorr, double NewAirCorr,
 
 
 //------------------------------------------------------------------------------
-// Line = operator : Copies the operator Line into the current class instance
+// id (const string &) : Sets the line identification to arg1, truncated to
+// LINE_ID_STRING_LEN characters as in a writelines file.
 //
-void Line::operator= (Line Operator) {
-  Index = Operator.line ();
-  Itn = Operator.itn ();
-  H = Operator.h ();
-  Wavenumber = Operator.wavenumber ();
-  Peak = Operator.peak ();
-  Width = Operator.width ();
-  Dmp = Operator.dmp ();
-  EqWidth = Operator.eqwidth ();
-  EpsTot = Operator.epstot ();
-  EpsEvn = Operator.epsevn ();
-  EpsOdd = Operator.epsodd ();
-  EpsRan = Operator.epsran ();
-  Wavelength = Operator.wavelength ();
-  Tags = Operator.tags ();
-  Identification = Operator.id ();
-  WavenumberCorrection = Operator.wavCorr ();
-  AirCorrection = Operator.airCorrection ();
-  IntensityCalibration = Operator.intensityCalibration ();
+void Line::id (const string &NewId) {
+  size_t Length = NewId.copy (Identification, LINE_ID_STRING_LEN);
+  Identification [Length] = '\0';
 }
 
 //------------------------------------------------------------------------------
-// checkInput (isstringstream &, const char *) : If a read error occurs in the
-// createLine function below, checkInput is called to examine the failed input.
-// If the error was caused by XGremlin writing ********** in a column rather
-// than a real value, a warning is printed and input is allowed to continue. Any
-// other error will cause an exception to be thrown.
+// createLine (string) : Creates a Line from an XGremlin "writelines" string
 //
-void Line::checkInput (istringstream &iss, const char* Err) throw (const char *) {
-  iss.clear ();
-  string TestInput;
-  iss >> TestInput;
-  if (TestInput == XG_OVERLOAD) {
-    cout << "Warning: " << XG_OVERLOAD << " has been found in the " << Err
-      << " column. A value of zero has been taken instead." << endl;
-    return;
-  } else {
-    throw Err;
-  }
+void Line::createLine (string LineString) throw (const char*) {
+  createLine (LineString.data (), LineString.data () + LineString.size ());
 }
 
 
 //------------------------------------------------------------------------------
-// createLine (string) : Creates a Line from an XGremlin "writelines" string
+// createLine (const char *, const char *, ParseDiagnostics *, unsigned int) :
+// Creates a Line from the XGremlin "writelines" row held in the character range
+// [arg1, arg2). Any overloads are recorded in arg3 as being in row arg4.
 //
-void Line::createLine (string LineString) throw (const char*) {
-  istringstream iss;
-  iss.str (LineString);
-  char IdCharString [LINE_ID_STRING_LEN];
-
-  // Read the contents of the Line string
-  iss >> skipws >> Index; if (iss.fail ()) { Index = 0; checkInput (iss, "index"); }
-  iss >> Wavenumber; if (iss.fail ()) { Wavenumber = 0.0; checkInput (iss, "wavenumber"); }
-  iss >> Peak; if (iss.fail ()) { Peak = 0.0; checkInput (iss, "peak height"); }
-  iss >> Width; if (iss.fail ()) { Width = 0.0; checkInput (iss, "width"); }
-  iss >> Dmp; if (iss.fail ()) { Dmp = 0.0; checkInput (iss, "dmp"); }
-  iss >> EqWidth; if (iss.fail ()) { EqWidth = 0.0; checkInput (iss, "eqwidth"); }
-  iss >> Itn; if (iss.fail ()) { Itn = 0; checkInput (iss, "itn"); }
-  iss >> H; if (iss.fail ()) { H = 0; checkInput (iss, "h"); }
-  iss >> Tags; if (iss.fail ()) if (iss.fail ()) throw ("tags");
-  iss >> EpsTot; if (iss.fail ()) { EpsTot = 0.0; checkInput (iss, "epstot"); }
-  iss >> EpsEvn; if (iss.fail ()) { EpsEvn = 0.0; checkInput (iss, "epsevn"); }
-  iss >> EpsOdd; if (iss.fail ()) { EpsOdd = 0.0; checkInput (iss, "epsodd"); }
-  iss >> EpsRan; if (iss.fail ()) { EpsRan = 0.0; checkInput (iss, "epsran"); }
-  iss >> ws;
+void Line::createLine (const char *Begin, const char *End,
+  ParseDiagnostics *Diagnostics, unsigned int RowNum) throw (const char*) {
+  RowTokenizer Row (Begin, End, Diagnostics, RowNum);
+
+  // Read the contents of the Line string, one field at a time as listed in
+  // WRITELINES_LAYOUT. The line identification is read as a fixed length
+  // string, as it may contain several words that could be interpreted as
+  // multiple fields. Whitespace at the end of the ID string is removed. If the
+  // field is empty, reading the wavelength after it will fail.
+  WRITELINES_LAYOUT (LAYOUT_INT_READ, LAYOUT_REAL_READ, LINE_TAG_READ,
+    LINE_TEXT_READ, LAYOUT_NONE)
   
-  // Read the line identification field based on a fixed length string. This is 
-  // needed as the field may contain several words that could be interpreted as
-  // multiple fields in a simple istringstream input operation.
-  iss.get (IdCharString, LINE_ID_STRING_LEN);
-  Identification = IdCharString;
-  iss >> Wavelength; if (iss.fail ()) { Wavelength = 0.0; checkInput (iss, "wavelength"); }
-
-  // Remove whitespace at the end of the ID string
-  for (int i = Identification.length () - 1; i >= 0; i --) {
-    if (Identification [i] == ' ') Identification.erase (i);
-    else break;
+  // Finally, remove any wavenumber correction from the internally stored params.
+  // Division by one changes nothing, so this is skipped when there is none.
+  if (WavenumberCorrection != 0.0) {
+    Wavenumber /= 1.0 + WavenumberCorrection;
+    Width /= 1.0 + WavenumberCorrection;
+    Wavelength *= 1.0 + WavenumberCorrection;
   }
-  
-  // Finally,remove the wavenumber correction from the internally stored params.
-  Wavenumber /= 1.0 + WavenumberCorrection;
-  Width /= 1.0 + WavenumberCorrection;
-  Wavelength *= 1.0 + WavenumberCorrection;
 }
 
 
@@ -167,14 +146,10 @@ void Line::print (ostream& Output) {
 // getLineSynString () : Returns the line properties in a formatted string for 
 // use with XGremlin's readlines command in 'syn' mode. 
 //
-string Line::getLineSynString () {
-  ostringstream oss;
-  oss.width (15); oss << left << Identification << "  ";
-  oss.width (12); oss.precision (5); oss << fixed << right << wavenumber ();
-  oss.width (10); oss.precision (4); oss << right << peak ();
-  oss.width (9);  oss.precision (2); oss << right << width ();
-  oss.width (8);  oss.precision (4); oss << right << dmp ();
-  return oss.str();
+string Line::getLineSynString () const {
+  OutputBuffer Buffer;
+  Buffer.print (LINE_SYN_FORMAT LINE_SYN_ARGS);
+  return Buffer.str ();
 }
 
 
@@ -182,26 +157,28 @@ string Line::getLineSynString () {
 // getLineString () : Returns the line properties in a formatted string matching
 // the XGremlin writelines file format.
 //
-string Line::getLineString () {
-  string IdLong = id();
-  IdLong.resize (LINE_ID_STRING_LEN, ' ');
-  ostringstream oss;
-  oss.width (6);  oss << right << Index << "  ";
-  oss.width (12); oss.precision (6); oss << fixed << right << wavenumber ();
-  oss.width (10); oss.precision (3); oss << scientific << right << peak ();
-  oss.width (9);  oss.precision (2); oss << fixed << right << width ();
-  oss.width (9);  oss.precision (4); oss << fixed << right << dmp ();
-  oss.width (11); oss.precision (4); oss << scientific << right << eqwidth ();
-  oss.width (6); oss << right << itn ();
-  oss.width (4); oss << right << h ();
-  oss.width (5); oss << right << tags ();
-  oss.width (11); oss.precision (4); oss << scientific << right << epstot ();
-  oss.width (11); oss.precision (4); oss << scientific << right << epsevn ();
-  oss.width (11); oss.precision (4); oss << scientific << right << epsodd ();
-  oss.width (11); oss.precision (4); oss << scientific << right << epsran ();
-  oss << left << " " << IdLong;
-  oss.width (11); oss.precision (6); oss << fixed << right << wavelength ();
-  return oss.str();
+string Line::getLineString () const {
+  OutputBuffer Buffer;
+  Buffer.print (LINE_STRING_FORMAT LINE_STRING_ARGS);
+  return Buffer.str ();
+}
+
+
+//------------------------------------------------------------------------------
+// writeLineSynString (OutputBuffer &) : Appends the 'syn' string returned by
+// getLineSynString() to the buffer at arg1, followed by a newline.
+//
+bool Line::writeLineSynString (OutputBuffer &Buffer) const {
+  return Buffer.print (LINE_SYN_FORMAT "\n" LINE_SYN_ARGS);
+}
+
+
+//------------------------------------------------------------------------------
+// writeLineString (OutputBuffer &) : Appends the writelines string returned by
+// getLineString() to the buffer at arg1, followed by a newline.
+//
+bool Line::writeLineString (OutputBuffer &Buffer) const {
+  return Buffer.print (LINE_STRING_FORMAT "\n" LINE_STRING_ARGS);
 }
 
 
@@ -41,6 +41,13 @@
 // use with the 'readlines' command. The line properties may also be printed to
 // a specified stream (or standard output by default) with the print() function.
 //
+// A Line holds all of its properties, including its identification, directly
+// in the object, with no pointers or strings to other memory. The compiler-
+// generated copy constructor and assignment therefore copy a Line as a single
+// block of memory, and a vector <Line> can be grown or copied cheaply. As the
+// uncorrected properties are copied, the copy has exactly the same wavenumber
+// correction as the original.
+//
 // Finally, getCentroidError(double) can be used to estimate the error in 
 // determining the line centroid, as calculated from the equation given by
 // Brault. This equation requires the line width and S/N ratio, and the spacing
@@ -55,6 +62,8 @@
 #include <string>
 #include <sstream>
 #include "ErrDefs.h"
+#include "outputbuffer.h"
+#include "diagnostics.h"
 
 // The default spacing between spectru data points, in cm^-1. This is used by
 // getCentroidError() when calculating the Brault line centre error.
@@ -78,24 +87,24 @@ class Line {
   
     // GET functions to access line properties. Apply the wavenumber correction
     // factor to any properties that require it.
-    int line () { return Index; }
-    int itn () { return Itn; }
-    int h () { return H; }
-    double wavenumber () { return Wavenumber * (1.0 + WavenumberCorrection); }
-    double peak () { return Peak; }
-    double width () { return Width * (1.0 + WavenumberCorrection); }
-    double dmp () { return Dmp; }
-    double eqwidth () { return EqWidth; }
-    double epstot () { return EpsTot; }
-    double epsevn () { return EpsEvn; }
-    double epsodd () { return EpsOdd; }
-    double epsran () { return EpsRan; }
-    double wavelength () { return Wavelength / (1.0 + WavenumberCorrection); }
-    char tags () { return Tags; }
-    string id () { return Identification; }
-    double wavCorr () { return WavenumberCorrection; }
-    double airCorrection () { return AirCorrection; }
-    double intensityCalibration () { return IntensityCalibration; }
+    int line () const { return Index; }
+    int itn () const { return Itn; }
+    int h () const { return H; }
+    double wavenumber () const { return Wavenumber * (1.0 + WavenumberCorrection); }
+    double peak () const { return Peak; }
+    double width () const { return Width * (1.0 + WavenumberCorrection); }
+    double dmp () const { return Dmp; }
+    double eqwidth () const { return EqWidth; }
+    double epstot () const { return EpsTot; }
+    double epsevn () const { return EpsEvn; }
+    double epsodd () const { return EpsOdd; }
+    double epsran () const { return EpsRan; }
+    double wavelength () const { return Wavelength / (1.0 + WavenumberCorrection); }
+    char tags () const { return Tags; }
+    string id () const { return Identification; }
+    double wavCorr () const { return WavenumberCorrection; }
+    double airCorrection () const { return AirCorrection; }
+    double intensityCalibration () const { return IntensityCalibration; }
     
     // SET functions to modify line properties
     void line (int NewIndex) { Index = NewIndex; }
@@ -112,29 +121,41 @@ class Line {
     void epsran (double NewEpsran) { EpsRan = NewEpsran; }
     void wavelength (double NewWavelength);
     void tags (char NewTags) { Tags = NewTags; }
-    void id (string NewId) { Identification = NewId; }
+    void id (const string &NewId);
     void wavCorr (double NewCorr){ WavenumberCorrection = NewCorr;}
     void airCorrection (double NewCorrection) { AirCorrection = NewCorrection; }
     void intensityCalibration (double NewCal) { IntensityCalibration = NewCal; }
     
     // Allow the user to create a Line from a string read from an XGremlin
-    // "writelines" output file.
+    // "writelines" output file. The second form reads the line directly from
+    // the characters in [Begin, End), such as a row of a memory-mapped file,
+    // without copying them. Any overloads in the row are recorded in
+    // Diagnostics, if given, as being in row Row of the file.
     void createLine (string LineString) throw (const char*);
-    
-    // An = operator to copy the contents of one line to another.
-    void operator= (Line Operator);
+    void createLine (const char *Begin, const char *End,
+      ParseDiagnostics *Diagnostics = NULL, unsigned int Row = 0)
+      throw (const char*);
     
     // Output functions. print (...) writes the line properties to a specified
     // stream or to std::cout by default. getLineSynString() and getLineString()
     // return the line properties in a format matching XGremlin's 'syn' and 
     // 'old' formats. See 'readlines' in the XGremlin manual for more info.
+    // writeLineSynString() and writeLineString() append the same strings,
+    // followed by a newline, to an OutputBuffer, and return false if the buffer
+    // could not be written out.
     void print (ostream& Output = std::cout);
-    string getLineSynString ();
-    string getLineString ();
+    string getLineSynString () const;
+    string getLineString () const;
+    bool writeLineSynString (OutputBuffer &Buffer) const;
+    bool writeLineString (OutputBuffer &Buffer) const;
     
     // Calculates the error in the line centroid position using the Brault eqn.
     double getCentroidError (double PointsInFwhm = DEF_POINT_SPACING);
     
+    // LineTable copies line properties directly to and from its columns,
+    // bypassing the range checks in the SET functions.
+    template <class Precision> friend class BasicLineTable;
+    
   private:
     // Line properties. Follows the naming convention used in the XGremlin
     // "writelines" output files.
@@ -142,17 +163,12 @@ class Line {
     double Wavenumber, Peak, Width, Dmp, EqWidth, EpsTot, 
       EpsEvn, EpsOdd, EpsRan, Wavelength;
     char Tags;
-    string Identification;
+    char Identification [LINE_ID_STRING_LEN + 1];
     
     // Header parameters from an XGremlin "writelines" file
     double WavenumberCorrection;
     double AirCorrection;
     double IntensityCalibration;
-    
-    // If an error is thrown while reading an XGremlin writelines file, check
-    // the nature of the error for known problems. If these can be handled, fix
-    // the problem. If not, continue to throw the error.
-    void checkInput (istringstream &iss, const char* Err) throw (const char *);
 };
     
 #endif // LINE_H
@@ -0,0 +1,345 @@
+// Xgtools
+// Copyright (C) M. P. Ruffoni 2011-2015
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// linecache.cpp
+//==============================================================================
+
+#include "linecache.h"
+#include "mappedfile.h"
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+
+// FNV-1a hash parameters
+#define FNV_OFFSET_BASIS 14695981039346656037ULL
+#define FNV_PRIME 1099511628211ULL
+
+// Every section of a cache file is aligned to this many bytes
+#define WLC_ALIGNMENT 8
+
+// Zero bytes used to pad each section to WLC_ALIGNMENT
+static const char Padding [WLC_ALIGNMENT] = { 0 };
+
+// Appended to the cache filename to give the mkstemp() template under which a
+// new cache is written before it is renamed
+#define WLC_TEMP_SUFFIX ".tmpXXXXXX"
+
+
+//------------------------------------------------------------------------------
+// writeString (ostream &, const string &) : Writes the string at arg2 to the
+// stream at arg1 as a 32-bit length followed by its characters.
+//
+static void writeString (ostream &Output, const string &String) {
+  uint32_t Length = String.size ();
+  Output.write ((const char *)&Length, sizeof (Length));
+  Output.write (String.data (), Length);
+}
+
+
+//------------------------------------------------------------------------------
+// readString (const char **, const char *, string *) : Reads a string written by
+// writeString() from the cache data at *arg1, advancing *arg1 past it. Returns
+// false if the string would extend beyond arg2.
+//
+static bool readString (const char **Position, const char *End, string *String) {
+  uint32_t Length;
+  if ((size_t)(End - *Position) < sizeof (Length)) return false;
+  memcpy (&Length, *Position, sizeof (Length));
+  *Position += sizeof (Length);
+  if ((size_t)(End - *Position) < Length) return false;
+  String -> assign (*Position, Length);
+  *Position += Length;
+  return true;
+}
+
+
+//------------------------------------------------------------------------------
+// LineCacheColumns : Copies the columns of a LineTable to and from a cache
+// file. LineTable declares this a friend so that its columns can be copied
+// as whole arrays.
+//
+class LineCacheColumns {
+  public:
+    static void write (ostream &Output, const LineTable &Lines);
+    static bool read (const char **Position, const char *End,
+      unsigned int NumLines, LineTable *Lines);
+    static void writeIds (ostream &Output, const LineTable &Lines);
+    static bool readIds (const char **Position, const char *End,
+      unsigned int NumIds, LineTable *Lines);
+
+  private:
+    template <class T>
+    static void writeColumn (ostream &Output, const vector <T> &Column);
+    template <class T>
+    static bool readColumn (const char **Position, const char *End,
+      unsigned int NumLines, vector <T> *Column);
+};
+
+
+//------------------------------------------------------------------------------
+// paddingFor (size_t) : Returns the number of bytes needed to pad a section of
+// arg1 bytes to the next WLC_ALIGNMENT boundary.
+//
+static size_t paddingFor (size_t Bytes) {
+  return (WLC_ALIGNMENT - Bytes % WLC_ALIGNMENT) % WLC_ALIGNMENT;
+}
+
+
+//------------------------------------------------------------------------------
+// writeColumn (ostream &, const vector <T> &) : Writes the values in the column
+// at arg2 to the stream at arg1, followed by any padding needed.
+//
+template <class T>
+void LineCacheColumns::writeColumn (ostream &Output, const vector <T> &Column) {
+  size_t Bytes = Column.size () * sizeof (T);
+  if (Bytes > 0) Output.write ((const char *)&Column[0], Bytes);
+  Output.write (Padding, paddingFor (Bytes));
+}
+
+
+//------------------------------------------------------------------------------
+// readColumn (const char **, const char *, unsigned int, vector <T> *) : Copies
+// a column of arg3 values from the cache data at *arg1 into the vector at arg4.
+// *arg1 is then advanced past the column and its padding. Returns false if the
+// column would extend beyond arg2.
+//
+template <class T>
+bool LineCacheColumns::readColumn (const char **Position, const char *End,
+  unsigned int NumLines, vector <T> *Column) {
+  size_t Bytes = (size_t)NumLines * sizeof (T);
+  if ((size_t)(End - *Position) < Bytes + paddingFor (Bytes)) return false;
+  Column -> resize (NumLines);
+  if (Bytes > 0) memcpy (&(*Column)[0], *Position, Bytes);
+  *Position += Bytes + paddingFor (Bytes);
+  return true;
+}
+
+
+//------------------------------------------------------------------------------
+// write (ostream &, const LineTable &) : Writes every column of the LineTable
+// at arg2 to the stream at arg1. The order here defines the file layout, and
+// must match read() below.
+//
+void LineCacheColumns::write (ostream &Output, const LineTable &Lines) {
+  writeColumn (Output, Lines.Index);
+  writeColumn (Output, Lines.Itn);
+  writeColumn (Output, Lines.H);
+  writeColumn (Output, Lines.Wavenumber);
+  writeColumn (Output, Lines.Peak);
+  writeColumn (Output, Lines.Width);
+  writeColumn (Output, Lines.Dmp);
+  writeColumn (Output, Lines.EqWidth);
+  writeColumn (Output, Lines.EpsTot);
+  writeColumn (Output, Lines.EpsEvn);
+  writeColumn (Output, Lines.EpsOdd);
+  writeColumn (Output, Lines.EpsRan);
+  writeColumn (Output, Lines.Wavelength);
+  writeColumn (Output, Lines.Tags);
+  writeColumn (Output, Lines.Id);
+}
+
+
+//------------------------------------------------------------------------------
+// read (const char **, const char *, unsigned int, LineTable *) : Reads every
+// column of a table of arg3 lines from the cache data at *arg1 into the
+// LineTable at arg4, advancing *arg1 past them. Returns false if the data end
+// before all the columns have been read.
+//
+bool LineCacheColumns::read (const char **Position, const char *End,
+  unsigned int NumLines, LineTable *Lines) {
+  return readColumn (Position, End, NumLines, &Lines -> Index)
+    && readColumn (Position, End, NumLines, &Lines -> Itn)
+    && readColumn (Position, End, NumLines, &Lines -> H)
+    && readColumn (Position, End, NumLines, &Lines -> Wavenumber)
+    && readColumn (Position, End, NumLines, &Lines -> Peak)
+    && readColumn (Position, End, NumLines, &Lines -> Width)
+    && readColumn (Position, End, NumLines, &Lines -> Dmp)
+    && readColumn (Position, End, NumLines, &Lines -> EqWidth)
+    && readColumn (Position, End, NumLines, &Lines -> EpsTot)
+    && readColumn (Position, End, NumLines, &Lines -> EpsEvn)
+    && readColumn (Position, End, NumLines, &Lines -> EpsOdd)
+    && readColumn (Position, End, NumLines, &Lines -> EpsRan)
+    && readColumn (Position, End, NumLines, &Lines -> Wavelength)
+    && readColumn (Position, End, NumLines, &Lines -> Tags)
+    && readColumn (Position, End, NumLines, &Lines -> Id);
+}
+
+
+//------------------------------------------------------------------------------
+// writeIds (ostream &, const LineTable &) : Writes the line identification pool
+// of the LineTable at arg2 to the stream at arg1.
+//
+void LineCacheColumns::writeIds (ostream &Output, const LineTable &Lines) {
+  for (unsigned int i = 0; i < Lines.IdPool.size (); i ++) {
+    writeString (Output, Lines.IdPool[i]);
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// readIds (const char **, const char *, unsigned int, LineTable *) : Reads a
+// pool of arg3 line identifications from the cache data at *arg1 into the
+// LineTable at arg4, advancing *arg1 past them. Returns false if the data end
+// early, or if any line refers to an identification not in the pool.
+//
+bool LineCacheColumns::readIds (const char **Position, const char *End,
+  unsigned int NumIds, LineTable *Lines) {
+  string NextId;
+  Lines -> IdPool.clear ();
+  Lines -> IdLookup.clear ();
+  for (unsigned int i = 0; i < NumIds; i ++) {
+    if (!readString (Position, End, &NextId)) return false;
+    Lines -> IdPool.push_back (NextId);
+    Lines -> IdLookup.insert (make_pair (NextId, i));
+  }
+  for (unsigned int i = 0; i < Lines -> Id.size (); i ++) {
+    if (Lines -> Id[i] >= NumIds) return false;
+  }
+  return true;
+}
+
+
+//------------------------------------------------------------------------------
+// hashContents (const char *, const char *) : Returns the FNV-1a hash of the
+// bytes in [arg1, arg2), taking 8 bytes at a time.
+//
+uint64_t hashContents (const char *Begin, const char *End) {
+  uint64_t Hash = FNV_OFFSET_BASIS;
+  uint64_t Word;
+  while (End - Begin >= (ptrdiff_t)sizeof (Word)) {
+    memcpy (&Word, Begin, sizeof (Word));
+    Hash = (Hash ^ Word) * FNV_PRIME;
+    Begin += sizeof (Word);
+  }
+  while (Begin < End) {
+    Hash = (Hash ^ (unsigned char)*Begin) * FNV_PRIME;
+    Begin ++;
+  }
+  return Hash;
+}
+
+
+//------------------------------------------------------------------------------
+// loadLineCache (string, const struct stat &, uint64_t, LineTable *,
+// vector <string> *) : Maps the cache file at arg1 into memory and, if it is a
+// valid cache of the line list described by arg2 and arg3, copies its contents
+// into the LineTable at arg4 and the header rows into arg5. Returns false if
+// not, in which case the LineTable may have been emptied.
+//
+bool loadLineCache (string CacheFilename, const struct stat &Source,
+  uint64_t SourceHash, LineTable *Lines, vector <string> *HeaderRows) {
+  MappedFile Cache (CacheFilename);
+  LineCacheHeader Header;
+  if (!Cache.isOpen () || Cache.size () < sizeof (Header)) return false;
+  memcpy (&Header, Cache.begin (), sizeof (Header));
+
+  // Check that this cache was made from the current line list by this version
+  // of the cache format
+  if (memcmp (Header.Magic, WLC_MAGIC, WLC_MAGIC_LEN) != 0
+    || Header.Version != WLC_VERSION
+    || Header.ByteOrder != WLC_BYTE_ORDER
+    || Header.RealSize != sizeof (LineTable::Real)
+    || Header.CacheSize != Cache.size ()
+    || Header.SourceSize != (uint64_t)Source.st_size
+    || Header.SourceMtime != (int64_t)Source.st_mtime
+    || Header.SourceHash != SourceHash) {
+    return false;
+  }
+
+  // Copy the columns straight into the LineTable. If the cache turns out to
+  // be incomplete, the table is emptied again.
+  vector <string> NewHeaderRows (Header.NumHeaderRows);
+  const char *Position = Cache.begin () + sizeof (Header);
+  bool Valid = LineCacheColumns::read (&Position, Cache.end (),
+    Header.NumLines, Lines);
+  for (unsigned int i = 0; Valid && i < Header.NumHeaderRows; i ++) {
+    Valid = readString (&Position, Cache.end (), &NewHeaderRows[i]);
+  }
+  Valid = Valid && LineCacheColumns::readIds (&Position, Cache.end (),
+    Header.NumIds, Lines);
+  if (!Valid) {
+    Lines -> clear ();
+    return false;
+  }
+  Lines -> wavCorr (Header.WavCorr);
+  HeaderRows -> swap (NewHeaderRows);
+  return true;
+}
+
+
+//------------------------------------------------------------------------------
+// saveLineCache (string, const struct stat &, uint64_t, const LineTable &,
+// const vector <string> &) : Writes the LineTable at arg4 and the header rows
+// at arg5 to the cache file at arg1. The file is first written under a
+// temporary name, and only renamed to arg1 once complete. The temporary file is
+// created with mkstemp(), so that several threads or processes writing the
+// same cache at once each write their own file, and the last rename wins. It
+// is given the permissions of the line list, as mkstemp() allows only its
+// owner to read it. Returns false if the cache could not be written.
+//
+bool saveLineCache (string CacheFilename, const struct stat &Source,
+  uint64_t SourceHash, const LineTable &Lines,
+  const vector <string> &HeaderRows) {
+  LineCacheHeader Header;
+  memset (&Header, 0, sizeof (Header));
+  memcpy (Header.Magic, WLC_MAGIC, WLC_MAGIC_LEN);
+  Header.Version = WLC_VERSION;
+  Header.ByteOrder = WLC_BYTE_ORDER;
+  Header.RealSize = sizeof (LineTable::Real);
+  Header.SourceSize = Source.st_size;
+  Header.SourceMtime = Source.st_mtime;
+  Header.SourceHash = SourceHash;
+  Header.NumLines = Lines.size ();
+  Header.NumIds = Lines.numIds ();
+  Header.NumHeaderRows = HeaderRows.size ();
+  Header.WavCorr = Lines.wavCorr ();
+
+  vector <char> TempName (CacheFilename.begin (), CacheFilename.end ());
+  TempName.insert (TempName.end (), WLC_TEMP_SUFFIX,
+    WLC_TEMP_SUFFIX + sizeof (WLC_TEMP_SUFFIX));
+  int TempFile = mkstemp (&TempName[0]);
+  if (TempFile == -1) return false;
+  string TempFilename (&TempName[0]);
+  fchmod (TempFile, Source.st_mode & 0666);
+  close (TempFile);
+  ofstream CacheFile (TempFilename.c_str (), ios::out | ios::binary);
+  if (!CacheFile.is_open ()) {
+    remove (TempFilename.c_str ());
+    return false;
+  }
+
+  // Write the header with CacheSize still zero, then fill it in at the end
+  CacheFile.write ((const char *)&Header, sizeof (Header));
+  LineCacheColumns::write (CacheFile, Lines);
+  for (unsigned int i = 0; i < HeaderRows.size (); i ++) {
+    writeString (CacheFile, HeaderRows[i]);
+  }
+  LineCacheColumns::writeIds (CacheFile, Lines);
+  Header.CacheSize = CacheFile.tellp ();
+  CacheFile.seekp (0);
+  CacheFile.write ((const char *)&Header, sizeof (Header));
+  CacheFile.close ();
+
+  if (CacheFile.fail () || rename (TempFilename.c_str (),
+    CacheFilename.c_str ()) != 0) {
+    remove (TempFilename.c_str ());
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,101 @@
+// Xgtools
+// Copyright (C) M. P. Ruffoni 2011-2015
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// linecache.h
+//==============================================================================
+// Reads and writes line list cache files. A cache file sits alongside an
+// XGremlin 'writelines' line list, with WLC_EXTENSION appended to its name,
+// and holds the LineTable parsed from that list in a binary form. The next
+// time the list is read, the table can be copied straight from the cache
+// rather than parsed again from text.
+//
+// A cache file begins with a LineCacheHeader, which records the size,
+// modification time and content hash of the line list from which it was made.
+// The cache is only used if all three still match the line list. It also
+// records the format version, byte order and the size of the LineTable's Real
+// type, so that a cache written by a different version of Xgtools, on a
+// different type of machine, or by a build with a different storage precision,
+// is simply ignored and rewritten.
+//
+// The header is followed by the LineTable columns, each stored as a plain
+// array of its values, and each starting on an 8-byte boundary. These are
+// followed by the rows of the line list header, and then the line
+// identification pool, each stored as a 32-bit length followed by its
+// characters. The whole file may therefore be mapped into memory and the
+// columns read in place.
+//
+// A missing, stale or unreadable cache is never an error. loadLineCache()
+// returns false, and the line list is parsed as normal. Likewise, if the cache
+// cannot be written, for example because the directory is read-only, the line
+// list is still returned. The cache is written to a temporary file and then
+// renamed, so a partly-written cache is never seen by another process.
+//
+#ifndef LINE_CACHE_H
+#define LINE_CACHE_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <sys/stat.h>
+#include "linetable.h"
+
+// The suffix appended to a line list filename to give its cache filename
+#define WLC_EXTENSION ".wlc"
+
+// The cache file identifier, format version, and byte order marker
+#define WLC_MAGIC "XGWLCACH"
+#define WLC_MAGIC_LEN 8
+#define WLC_VERSION 2
+#define WLC_BYTE_ORDER 0x01020304
+
+using namespace::std;
+
+// The fixed-size header at the start of every cache file
+typedef struct td_LineCacheHeader {
+  char Magic [WLC_MAGIC_LEN];
+  uint32_t Version;
+  uint32_t ByteOrder;
+  uint64_t SourceSize;    // Size of the line list in bytes
+  int64_t SourceMtime;    // Modification time of the line list
+  uint64_t SourceHash;    // hashContents() of the line list
+  uint64_t CacheSize;     // Size of the whole cache file in bytes
+  uint32_t NumLines;
+  uint32_t NumIds;
+  uint32_t NumHeaderRows;
+  uint32_t RealSize;      // sizeof (LineTable::Real)
+  double WavCorr;
+} LineCacheHeader;
+
+// Returns a 64-bit FNV-1a hash of the bytes in [Begin, End). For speed, the
+// data are hashed 8 bytes at a time, with any remaining bytes hashed singly.
+uint64_t hashContents (const char *Begin, const char *End);
+
+// Fills the LineTable at arg4 and the header rows at arg5 from the cache file
+// at arg1, if that cache was made from a line list with the size and
+// modification time at arg2 and the hash at arg3. Returns false if the cache
+// is missing or does not match, in which case arg4 may have been emptied.
+bool loadLineCache (string CacheFilename, const struct stat &Source,
+  uint64_t SourceHash, LineTable *Lines, vector <string> *HeaderRows);
+
+// Writes the LineTable at arg4 and the header rows at arg5 to the cache file
+// at arg1, recording the line list size, modification time and hash given at
+// arg2 and arg3. Returns false if the cache could not be written.
+bool saveLineCache (string CacheFilename, const struct stat &Source,
+  uint64_t SourceHash, const LineTable &Lines,
+  const vector <string> &HeaderRows);
+
+#endif // LINE_CACHE_H
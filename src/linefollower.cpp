@@ -0,0 +1,291 @@
+// Xgtools
+// Copyright (C) M. P. Ruffoni 2011-2015
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// linefollower.cpp
+//
+// Implements the LineListFollower class declared in linefollower.h. As the
+// follower reads its line list with the same routines as readLineList(), this
+// file includes lineio.cpp, and is included by listcal.cpp in the same way.
+//
+#ifndef LINE_FOLLOWER_CPP
+#define LINE_FOLLOWER_CPP
+
+#include <iostream>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#endif
+#include "ErrDefs.h"
+#include "linefollower.h"
+#include "lineio.cpp"
+
+// The inotify events after which a followed line list should be read again
+#define LF_WATCH_EVENTS \
+  (IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_MOVE_SELF | IN_DELETE_SELF)
+
+// The size of the buffer into which pending inotify events are discarded
+#define LF_EVENT_BUFFER_SIZE 4096 /* bytes */
+
+
+//------------------------------------------------------------------------------
+// Class constructors. The second form starts following the line list at arg1
+// at once, though nothing is read from it until the first call to poll().
+//
+LineListFollower::LineListFollower () {
+  Notify = -1;
+  Watch = -1;
+  open ("");
+}
+
+LineListFollower::LineListFollower (string NewFilename) {
+  Notify = -1;
+  Watch = -1;
+  open (NewFilename);
+}
+
+
+//------------------------------------------------------------------------------
+// open (string) : Starts following the line list at arg1 from its first row,
+// forgetting any list that was followed before.
+//
+void LineListFollower::open (string NewFilename) {
+  close ();
+  Filename = NewFilename;
+  Offset = 0;
+  RowNum = 0;
+  WavCorr = 0.0;
+  Device = 0;
+  Inode = 0;
+  Reset = false;
+  Head.clear ();
+  LastRow.clear ();
+}
+
+
+//------------------------------------------------------------------------------
+// close () : Stops watching the line list for changes.
+//
+void LineListFollower::close () {
+  if (Notify >= 0) ::close (Notify);
+  Notify = -1;
+  Watch = -1;
+  Buffer.clear ();
+}
+
+
+//------------------------------------------------------------------------------
+// watch () : Starts watching the line list for changes with inotify, replacing
+// any earlier watch, which may be on a file that has since been replaced. Does
+// nothing if inotify is not available, in which case wait() just sleeps.
+//
+void LineListFollower::watch () {
+#ifdef __linux__
+  if (Notify < 0) Notify = inotify_init1 (IN_NONBLOCK | IN_CLOEXEC);
+  if (Notify < 0) return;
+  if (Watch >= 0) inotify_rm_watch (Notify, Watch);
+  Watch = inotify_add_watch (Notify, Filename.c_str (), LF_WATCH_EVENTS);
+#endif
+}
+
+
+//------------------------------------------------------------------------------
+// wait (unsigned int) : Blocks until the line list changes, or for arg1
+// milliseconds, whichever comes first. Any pending change events are then
+// discarded, as the next poll() reads every change at once.
+//
+void LineListFollower::wait (unsigned int Timeout) {
+#ifdef __linux__
+  if (Watch >= 0) {
+    struct pollfd Event;
+    char Events [LF_EVENT_BUFFER_SIZE];
+    Event.fd = Notify;
+    Event.events = POLLIN;
+    if (::poll (&Event, 1, Timeout) > 0) {
+      while (read (Notify, Events, sizeof (Events)) > 0);
+    }
+    return;
+  }
+#endif
+  usleep (Timeout * 1000);
+}
+
+
+//------------------------------------------------------------------------------
+// restart (LineTable *) : Empties the table at arg1 so that the line list can
+// be read again from the top.
+//
+void LineListFollower::restart (LineTable *Lines) {
+  Reset = RowNum > 0;
+  Offset = 0;
+  RowNum = 0;
+  WavCorr = 0.0;
+  Head.clear ();
+  LastRow.clear ();
+  Lines -> clear ();
+  Lines -> wavCorr (0.0);
+}
+
+
+//------------------------------------------------------------------------------
+// readsAs (int, off_t, const string &) : Returns true if the file open on arg1
+// holds the bytes of arg3 at the offset given by arg2.
+//
+static bool readsAs (int Fd, off_t Position, const string &Expected) {
+  if (Expected.empty ()) return true;
+  vector <char> Found (Expected.size ());
+  size_t BytesRead = 0;
+  while (BytesRead < Found.size ()) {
+    ssize_t Count = pread (Fd, &Found[BytesRead], Found.size () - BytesRead,
+      Position + BytesRead);
+    if (Count <= 0) return false;
+    BytesRead += Count;
+  }
+  return Expected.compare (0, string::npos, &Found[0], Found.size ()) == 0;
+}
+
+
+//------------------------------------------------------------------------------
+// lastRow (const char *, const char *) : Returns the last of the complete rows
+// in [Begin, End), including its newline.
+//
+static string lastRow (const char *Begin, const char *End) {
+  const char *Row = End - 1;
+  while (Row > Begin && Row[-1] != '\n') Row --;
+  return string (Row, End);
+}
+
+
+//------------------------------------------------------------------------------
+// unchanged (int) : Returns true if the list open on arg1 still holds the
+// header rows and the last row read by earlier calls to poll() where they were
+// read. If not, the list has been rewritten in place, not just appended to.
+//
+bool LineListFollower::unchanged (int Fd) {
+  if (Offset == 0) return true;
+  return readsAs (Fd, 0, Head) 
+    && readsAs (Fd, Offset - (off_t)LastRow.size (), LastRow);
+}
+
+
+//------------------------------------------------------------------------------
+// readHeader (const char *, const char *, WritelinesHeader *) : Reads any
+// header rows not yet read from the complete rows in [Begin, End) into the
+// header at arg3. The wavenumber correction is taken from the first header row
+// as soon as it is read. Returns the start of the first row not read.
+//
+const char *LineListFollower::readHeader (const char *Begin, const char *End,
+  WritelinesHeader *Header) throw (int) {
+  string *HeaderRows [XG_WRITELINES_HEADER_LENGTH] = {
+    &Header -> WaveCorr, &Header -> AirCorr, &Header -> IntCal, 
+    &Header -> Columns };
+  while (Begin < End && RowNum < XG_WRITELINES_HEADER_LENGTH) {
+    const char *RowEnd = (const char *) memchr (Begin, '\n', End - Begin);
+    HeaderRows [RowNum] -> assign (Begin, RowEnd);
+    Head.append (Begin, RowEnd + 1);
+    if (RowNum == 0) WavCorr = getWavCorr (Header -> WaveCorr);
+    RowNum ++;
+    Begin = RowEnd + 1;
+  }
+  return Begin;
+}
+
+
+//------------------------------------------------------------------------------
+// poll (LineTable *, WritelinesHeader *) : Reads the bytes appended to the line
+// list since the last call, and adds a line to the table at arg1 for each
+// complete row among them. Any header rows are stored in arg2, and the table's
+// wavenumber correction taken from the header. If the list has shrunk or been
+// replaced, or rewritten in place, the table is first emptied and the list read
+// from the top. Returns the number of lines added.
+//
+unsigned int LineListFollower::poll (LineTable *Lines, 
+  WritelinesHeader *Header) throw (int) {
+  struct stat ListStat;
+  const char *Begin, *End, *Err;
+  unsigned int FailedRow;
+  Reset = false;
+  
+  // Open the list. Once it has been read, the list may briefly be missing
+  // while it is replaced, so this is only an error on the first call.
+  int Fd = ::open (Filename.c_str (), O_RDONLY);
+  if (Fd < 0 || fstat (Fd, &ListStat) != 0) {
+    if (Fd >= 0) ::close (Fd);
+    if (Inode != 0) return 0;
+    cout << "Error: Cannot read " << Filename 
+      << ". Check the file exists and has read permissions." << endl;
+    throw int(LC_FILE_OPEN_ERROR);
+  }
+  if (ListStat.st_dev != Device || ListStat.st_ino != Inode 
+    || ListStat.st_size < Offset || !unchanged (Fd)) {
+    restart (Lines);
+    Device = ListStat.st_dev;
+    Inode = ListStat.st_ino;
+    watch ();
+  }
+
+  // Read everything appended since the last call. Only the complete rows are
+  // used. Any partial row at the end is read again next time.
+  Buffer.resize (ListStat.st_size - Offset);
+  size_t BytesRead = 0;
+  while (BytesRead < Buffer.size ()) {
+    ssize_t Count = pread (Fd, &Buffer[BytesRead], Buffer.size () - BytesRead,
+      Offset + BytesRead);
+    if (Count <= 0) break;
+    BytesRead += Count;
+  }
+  ::close (Fd);
+  while (BytesRead > 0 && Buffer[BytesRead - 1] != '\n') BytesRead --;
+  if (BytesRead == 0) return 0;
+  Begin = &Buffer[0];
+  End = Begin + BytesRead;
+  
+  // Read any header rows still missing, then parse the remaining rows. These
+  // are added to the table only if every row can be read, so that a bad row
+  // is reported again, rather than skipped, by the next call.
+  const char *HeaderEnd = readHeader (Begin, End, Header);
+  if (HeaderEnd != Begin) {
+    Offset += HeaderEnd - Begin;
+    LastRow = lastRow (Begin, HeaderEnd);
+  }
+  Begin = HeaderEnd;
+  Lines -> wavCorr (WavCorr);
+  if (Begin == End) return 0;
+  vector <Line> NewLines;
+  ParseDiagnostics Diagnostics;
+  FailedRow = parseLineRows (Begin, End, WavCorr, &NewLines, &Err, 
+    &Diagnostics);
+  Diagnostics.report (cout, Filename, RowNum);
+  if (FailedRow) {
+    cout << "Error reading " << Err << " from line " << FailedRow + RowNum 
+      << " in " << Filename << ". File loading aborted." << endl;
+    throw int(LC_FILE_READ_ERROR);
+  }
+  for (unsigned int i = 0; i < NewLines.size (); i ++) {
+    Lines -> addLine (NewLines[i]);
+  }
+  for (const char *Row = Begin; Row < End; Row ++) {
+    if (*Row == '\n') RowNum ++;
+  }
+  Offset += End - Begin;
+  LastRow = lastRow (Begin, End);
+  return NewLines.size ();
+}
+
+#endif // LINE_FOLLOWER_CPP
@@ -0,0 +1,122 @@
+// Xgtools
+// Copyright (C) M. P. Ruffoni 2011-2015
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// LineListFollower class (linefollower.h)
+//==============================================================================
+// Follows an XGremlin 'writelines' line list that is still being written, as
+// 'tail -f' does, adding each newly appended line to a LineTable. This lets a
+// line list be calibrated while XGremlin is still appending lines to it,
+// without the whole list being read again each time it grows.
+//
+// The follower remembers the byte offset just beyond the last complete row it
+// has read, the number of rows read so far, and the wavenumber correction from
+// the header. Each call to poll() then reads only the bytes appended since the
+// last call, and parses the complete rows among them with parseLineRows(). A
+// final row that has no newline yet may still be being written, so is left for
+// a later poll(). The four header rows are read in the same way, one at a time
+// as each is completed, and no lines are added until all four have been read.
+//
+// wait() blocks until the line list changes or a timeout expires. On Linux,
+// the list is watched with inotify, so wait() returns as soon as a row is
+// appended. Elsewhere, wait() simply sleeps for the timeout.
+//
+//   LineListFollower Follower (Filename);
+//   LineTable Lines;
+//   WritelinesHeader Header;
+//   Follower.poll (&Lines, &Header);
+//   while (true) {
+//     Follower.wait (LF_POLL_INTERVAL);
+//     if (Follower.poll (&Lines, &Header)) { ... }
+//   }
+//
+// If the line list shrinks or is replaced by a new file, the rows already read
+// no longer describe it, so the table is emptied and the new list is read from
+// the top. The same is done if the list is rewritten in place, which poll()
+// detects by keeping the header rows and the last row it has read, and checking
+// that these are still found where they were. A rewrite that leaves both
+// unchanged is indistinguishable from a list that has only been appended to,
+// and is not noticed. reset() reports when the list has been read again from
+// the top during the last poll(). The
+// errors thrown by poll() are those of readLineList(). A list that does not
+// (yet) exist, or a compressed list, cannot be followed. As the table is built
+// a few rows at a time, it is never read from or written to a cache file.
+//
+#ifndef LINE_FOLLOWER_H
+#define LINE_FOLLOWER_H
+
+#include <string>
+#include <vector>
+#include <sys/types.h>
+#include "linetable.h"
+#include "diagnostics.h"
+#include "writelinesheader.h"
+
+// The default time, in milliseconds, for which wait() blocks
+#define LF_POLL_INTERVAL 1000
+
+using namespace::std;
+
+class LineListFollower {
+  public:
+    LineListFollower ();
+    LineListFollower (string NewFilename);
+    ~LineListFollower () { close (); }
+
+    // Starts following the line list at arg1, and stops following it
+    void open (string NewFilename);
+    void close ();
+
+    // Adds the lines appended to the list since the last call to the table at
+    // arg1, and stores the header rows at arg2 once they have all been read.
+    // Returns the number of lines added.
+    unsigned int poll (LineTable *Lines, WritelinesHeader *Header) throw (int);
+
+    // Blocks until the list changes or arg1 milliseconds have passed
+    void wait (unsigned int Timeout = LF_POLL_INTERVAL);
+
+    // GET functions for the list being followed and the progress through it
+    const string &filename () const { return Filename; }
+    off_t offset () const { return Offset; }
+    unsigned int row () const { return RowNum; }
+    bool reset () const { return Reset; }
+
+  private:
+    string Filename;
+    off_t Offset;             // Byte offset of the first unread row
+    unsigned int RowNum;      // Number of complete rows read
+    double WavCorr;           // The wavenumber correction from the header
+    dev_t Device;             // Identity of the file being read, to detect
+    ino_t Inode;              // the list being replaced
+    bool Reset;
+    string Head;              // The header rows read, and the last row read,
+    string LastRow;           // each with its newline, to detect a rewrite
+    vector <char> Buffer;     // The bytes appended since the last poll ()
+    int Notify, Watch;        // inotify descriptors, or -1 if unused
+
+    // Helpers for poll(). See linefollower.cpp.
+    void restart (LineTable *Lines);
+    bool unchanged (int Fd);
+    const char *readHeader (const char *Begin, const char *End,
+      WritelinesHeader *Header) throw (int);
+    void watch ();
+
+    // A LineListFollower owns its inotify descriptors, so must not be copied.
+    LineListFollower (const LineListFollower &);
+    void operator= (const LineListFollower &);
+};
+
+#endif // LINE_FOLLOWER_H
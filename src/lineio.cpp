@@ -22,10 +22,15 @@
 // write routines, writeSynLines(...), enable line data to be saved in the 'syn'
 // format for use by XGremlin's 'readlines' command.
 //
-// On input, readLineList(...) extracts the lines from an XGremlin 'writelines'
-// file and stores each in a Line object. Conversely, on output, a vector of 
-// Line objects is passed to either writeLines(...) or writeSynLines(...) and 
-// written in 'writelines' or 'syn' format respectively.
+// On input, readLineList(...) maps an XGremlin 'writelines' file into memory,
+// extracts the lines from it in place, and stores each in a Line object. A
+// gzip or zstd compressed file is decompressed into memory instead (see
+// mappedfile.h).
+// Conversely, on output, a vector of Line objects is passed to either 
+// writeLines(...) or writeSynLines(...) and written in 'writelines' or 'syn'
+// format respectively. writeLines(...) also accepts a LineView, so that a
+// LineTable can be written with a new wavenumber correction without first
+// being copied into Line objects.
 // 
 #ifndef LINE_IO_CPP
 #define LINE_IO_CPP
@@ -37,17 +42,15 @@
 #include <sstream>
 #include <fstream>
 #include <vector>
+#include <cstdio>
 #include "ErrDefs.h"
 #include "line.h"
-
-// A namespace to store the header from the XGremlin writelines file. This can
-// then be used to copy the header to the output line list in writeLines().
-namespace writelines_header {
-  string WaveCorr;
-  string AirCorr;
-  string IntCal;
-  string Columns;
-}
+#include "linetable.h"
+#include "linecache.h"
+#include "mappedfile.h"
+#include "chunkparse.h"
+#include "outputbuffer.h"
+#include "writelinesheader.h"
 
 
 //------------------------------------------------------------------------------
@@ -77,35 +80,48 @@ double getWavCorr (string HeaderLine) throw (int) {
     
 
 //------------------------------------------------------------------------------
-// readLineList (string, vector <Line>) : Opens and reads an XGremlin writelines
-// line list. The string from each individual row in the ascii file is passed to
-// the Line object constructor, which extracts the line parameters. The
-// resulting Line object is added to the Line vector at arg2, which, being 
-// passed in by reference, is returned to the calling function.
+// readLineList (string, vector <Line> *, WritelinesHeader *) : Opens and reads
+// an XGremlin writelines line list. The file is mapped into memory and the rows
+// below the header are parsed in place by parseLineRows(), which splits them
+// between several threads for large files. Each row is passed straight from the
+// mapping to Line::createLine(), which extracts the line parameters into a Line
+// constructed directly in the vector at arg2. The header rows are stored in
+// arg3. Being passed in by reference, both are returned to the calling function.
 //
-void readLineList (string Filename, vector <Line> *Lines) throw (int) {
-  string LineString;
+void readLineList (string Filename, vector <Line> *Lines, 
+  WritelinesHeader *Header) throw (int) {
+  const char *Row, *RowEnd, *NextRow, *Err;
   double WavCorr = 0.0;
-  unsigned int LineCount = XG_WRITELINES_HEADER_LENGTH;
+  unsigned int FailedRow;
   // Open the specified line list and abort if it cannot be read.
-  ifstream ListFile (Filename.c_str(), ios::in);
-  if (! ListFile.is_open()) {
+  MappedFile ListFile (Filename);
+  if (! ListFile.isOpen()) {
     cout << "Error: Cannot read " << Filename 
       << ". Check the file exists and has read permissions." << endl;
     throw int(LC_FILE_OPEN_ERROR);
   }
   
-  // Extract the data from the line list header
+  // Extract the data from the line list header. As with getline, a header row
+  // can only be missing if the end of the file has already been reached.
+  Row = ListFile.begin ();
   try {
-    getline (ListFile, writelines_header::WaveCorr); // wavenumber correction
-    WavCorr = getWavCorr (writelines_header::WaveCorr);
-    if (ListFile.fail()) throw(" wavenumber correction ");
-    getline (ListFile, writelines_header::AirCorr);  // air correction
-    if (ListFile.fail()) throw("  air correction ");
-    getline (ListFile, writelines_header::IntCal);   // intensity calibration
-    if (ListFile.fail()) throw(" intensity calibration ");
-    getline (ListFile, writelines_header::Columns);  // column headers
-    if (ListFile.fail()) throw(" column headers ");
+    NextRow = ListFile.nextRow (Row, &RowEnd);      // wavenumber correction
+    Header -> WaveCorr.assign (Row, RowEnd);
+    WavCorr = getWavCorr (Header -> WaveCorr);
+    if (Row == ListFile.end ()) throw(" wavenumber correction ");
+    Row = NextRow;
+    NextRow = ListFile.nextRow (Row, &RowEnd);      // air correction
+    Header -> AirCorr.assign (Row, RowEnd);
+    if (Row == ListFile.end ()) throw("  air correction ");
+    Row = NextRow;
+    NextRow = ListFile.nextRow (Row, &RowEnd);      // intensity calibration
+    Header -> IntCal.assign (Row, RowEnd);
+    if (Row == ListFile.end ()) throw(" intensity calibration ");
+    Row = NextRow;
+    NextRow = ListFile.nextRow (Row, &RowEnd);      // column headers
+    Header -> Columns.assign (Row, RowEnd);
+    if (Row == ListFile.end ()) throw(" column headers ");
+    Row = NextRow;
   } catch (const char* Line) {
     cout << "Error reading" << Line << "from the " << Filename << " header.\n"
       << "Check the file was written with XGremlin's 'writelines' command.\n"
@@ -115,59 +131,124 @@ void readLineList (string Filename, vector <Line> *Lines) throw (int) {
     throw int(LC_FILE_HEAD_ERROR);
   }
       
-  // Create a new Line object for each line in the list. Store these in the 
-  // Lines vector.
-  Lines -> clear ();
-  try {
-    while (!ListFile.eof ()) {
-      LineCount ++;
-      getline (ListFile, LineString);
-      if (LineString[0] != '\0') {
-        Lines -> push_back (Line (LineString, WavCorr));
-      }
-    }
-  } catch (const char* Err) {
-    cout << "Error reading " << Err << " from line " << LineCount << " in " 
+  // Create a new Line object for each line in the list. If any row cannot be
+  // read, the first such row in the file is reported, counting rows from the
+  // top of the file, and Lines holds only the lines that precede it. Any
+  // overloads are reported together once parsing is complete.
+  ParseDiagnostics Diagnostics;
+  FailedRow = parseLineRows (Row, ListFile.end (), WavCorr, Lines, &Err,
+    &Diagnostics);
+  Diagnostics.report (cout, Filename, XG_WRITELINES_HEADER_LENGTH);
+  if (FailedRow) {
+    cout << "Error reading " << Err << " from line " 
+      << FailedRow + XG_WRITELINES_HEADER_LENGTH << " in " 
       << Filename << ". File loading aborted." << endl;
     throw int(LC_FILE_READ_ERROR);
   }
-  ListFile.close ();
 }
 
 
 //------------------------------------------------------------------------------
-// writeLines (vector <Line>, ostream) : Requests the XGremlin writelines string
-// from each Line in the vector at arg1 and sends this string to the stream at
-// arg2.
+// readLineList (string, LineTable *, WritelinesHeader *) : Reads an XGremlin
+// writelines line list as above, and stores the lines in the LineTable at arg2
+// and the header rows in arg3. If a valid cache of
+// the line list exists (see linecache.h), the lines and header are loaded from
+// the cache instead, without parsing the list. Otherwise, the list is parsed
+// and a new cache written for next time.
+//
+void readLineList (string Filename, LineTable *Lines, 
+  WritelinesHeader *Header) throw (int) {
+  struct stat SourceStat;
+  MappedFile Source;
+  uint64_t SourceHash = 0;
+  string CacheFilename = Filename + WLC_EXTENSION;
+  vector <string> HeaderRows;
+  
+  // Only regular files are cached, as only they have a meaningful size and
+  // modification time. A compressed list is hashed as it is stored, without
+  // decompressing it, as this identifies its contents just as well.
+  bool Cacheable = stat (Filename.c_str (), &SourceStat) == 0 
+    && S_ISREG (SourceStat.st_mode) && Source.open (Filename, false);
+  if (Cacheable) {
+    SourceHash = hashContents (Source.begin (), Source.end ());
+    Source.close ();
+    if (loadLineCache (CacheFilename, SourceStat, SourceHash, Lines, 
+      &HeaderRows) && HeaderRows.size () == XG_WRITELINES_HEADER_LENGTH) {
+      Header -> WaveCorr = HeaderRows[0];
+      Header -> AirCorr = HeaderRows[1];
+      Header -> IntCal = HeaderRows[2];
+      Header -> Columns = HeaderRows[3];
+      return;
+    }
+  }
+  
+  vector <Line> ListLines;
+  readLineList (Filename, &ListLines, Header);
+  Lines -> assign (ListLines);
+  Lines -> wavCorr (getWavCorr (Header -> WaveCorr));
+  if (Cacheable) {
+    HeaderRows.clear ();
+    HeaderRows.push_back (Header -> WaveCorr);
+    HeaderRows.push_back (Header -> AirCorr);
+    HeaderRows.push_back (Header -> IntCal);
+    HeaderRows.push_back (Header -> Columns);
+    saveLineCache (CacheFilename, SourceStat, SourceHash, *Lines, HeaderRows);
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// lineError (const Line &) : Returns the "line N" string thrown by writeLines()
+// and writeSynLines() when the Line at arg1 could not be written. The string is
+// held in a static buffer so that it remains valid after being thrown.
 //
-void writeLines (vector <Line> Lines, ostream &Output = std::cout) throw (const char*) {
+const char *lineError (const Line &FailedLine) {
+  static char Err [32];
+  snprintf (Err, sizeof (Err), "line %d", FailedLine.line ());
+  return Err;
+}
+
+
+//------------------------------------------------------------------------------
+// writeLines (const LineList &, const WritelinesHeader &, ostream) : Writes the
+// header at arg2, followed by the XGremlin writelines string of each line in
+// arg1, to the stream at arg3. LineList may be a vector <Line> or a LineView.
+// The rows are formatted into a single OutputBuffer, which is written to the
+// stream only when full, rather than formatting and flushing each row
+// separately.
+//
+template <class LineList>
+void writeLines (const LineList &Lines, const WritelinesHeader &Header,
+  ostream &Output = std::cout) throw (const char*) {
   if (Lines[0].wavCorr () != 0.0) {
     Output << "  WAVENUMBER CORRECTION APPLIED: wavcorr =   " 
       << Lines[0].wavCorr () << endl;
   }
   else {
-    Output << writelines_header::WaveCorr << endl;
+    Output << Header.WaveCorr << endl;
   }
-  Output << writelines_header::AirCorr << endl;
-  Output << writelines_header::IntCal << endl;
-  Output << writelines_header::Columns << endl;
+  Output << Header.AirCorr << endl;
+  Output << Header.IntCal << endl;
+  Output << Header.Columns << endl;
   if (Output.fail()) throw "the file header";
+  OutputBuffer Buffer (Output);
   for (unsigned int i = 0; i < Lines.size (); i ++) {
-    Output << Lines[i].getLineString() << endl;
-    if (Output.fail ()) {
-      ostringstream oss;
-      oss << "line " << Lines[i].line ();
-      throw oss.str().c_str();
-    }
+    if (!Lines[i].writeLineString (Buffer)) throw lineError (Lines[i]);
   }
+  if (!Buffer.flush ()) throw lineError (Lines[Lines.size () - 1]);
+  Output.flush ();
+  if (Output.fail ()) throw lineError (Lines[Lines.size () - 1]);
 }
 
 //------------------------------------------------------------------------------
-// writeLines (vector <Line>, string) : Creates an output file stream from
-// the filename specified at arg2, then calls writeLines (vector <Line>,
-// ostream) to output the XGremlin writelines data to this file.
+// writeLines (const LineList &, const WritelinesHeader &, string) : Creates an
+// output file stream from the filename specified at arg3, then calls
+// writeLines (LineList, WritelinesHeader, ostream) to output the XGremlin
+// writelines data to this file.
 //
-void writeLines (vector <Line> Lines, string Filename) throw (int) {
+template <class LineList>
+void writeLines (const LineList &Lines, const WritelinesHeader &Header,
+  string Filename) throw (int) {
   ofstream ListFile (Filename.c_str(), ios::out);
   if (! ListFile.is_open()) {
     cout << "Error: Cannot open " << Filename 
@@ -175,7 +256,7 @@ void writeLines (vector <Line> Lines, string Filename) throw (int) {
     throw int (LC_FILE_OPEN_ERROR);
   }
   try {
-    writeLines (Lines, ListFile);
+    writeLines (Lines, Header, ListFile);
   } catch (const char *Err) {
     cout << "Error writing " << Err << " to " << Filename << 
       ". List writing ABORTED." << endl;
@@ -185,27 +266,28 @@ void writeLines (vector <Line> Lines, string Filename) throw (int) {
 
 
 //------------------------------------------------------------------------------
-// writeSynLines (vector <Line>, ostream) : Requests the XGremlin 'syn' string
-// from each Line in the vector at arg1 and sends this string to the stream at
-// arg2.
+// writeSynLines (const vector <Line> &, ostream) : Writes the XGremlin 'syn'
+// string of each Line in the vector at arg1 to the stream at arg2, through an
+// OutputBuffer as in writeLines().
 //
-void writeSynLines (vector <Line> Lines, ostream &Output = std::cout) throw (const char*) {
+void writeSynLines (const vector <Line> &Lines, ostream &Output = std::cout) 
+  throw (const char*) {
+  if (Lines.empty ()) return;
+  OutputBuffer Buffer (Output);
   for (unsigned int i = 0; i < Lines.size (); i ++) {
-    Output << Lines[i].getLineSynString() << endl;
-    if (Output.fail ()) {
-      ostringstream oss;
-      oss << "line " << Lines[i].line ();
-      throw oss.str().c_str();
-    }
+    if (!Lines[i].writeLineSynString (Buffer)) throw lineError (Lines[i]);
   }
+  if (!Buffer.flush ()) throw lineError (Lines.back ());
+  Output.flush ();
+  if (Output.fail ()) throw lineError (Lines.back ());
 }
 
 //------------------------------------------------------------------------------
-// writeSynLines (vector <Line>, string) : Creates an output file stream from
-// the filename specified at arg2, then calls writeSynLines (vector <Line>,
+// writeSynLines (const vector <Line> &, string) : Creates an output file stream
+// from the filename specified at arg2, then calls writeSynLines (vector <Line>,
 // ostream) to output the XGremlin 'syn' data to this file.
 //
-void writeSynLines (vector <Line> Lines, string Filename) throw (int) {
+void writeSynLines (const vector <Line> &Lines, string Filename) throw (int) {
   ofstream ListFile (Filename.c_str(), ios::out);
   if (! ListFile.is_open()) {
     cout << "Error: Cannot open " << Filename 
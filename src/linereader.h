@@ -0,0 +1,151 @@
+// Xgtools
+// Copyright (C) M. P. Ruffoni 2011-2015
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// LineListReader class (linereader.h)
+//==============================================================================
+// Reads an XGremlin 'writelines' line list one line at a time. Unlike
+// readLineList(), which returns every line in the list at once, only the line
+// most recently read is ever held in memory, so a list of any length can be
+// processed in constant memory. This suits tools that convert or filter a line
+// list row by row.
+//
+// The lines are created through a ChunkStrings (see chunkparse.h), which is
+// cleared before each row is read. An XgLine therefore keeps its strings in a
+// pool belonging to the reader rather than in the pool shared by every XgLine,
+// and its tags, id and name are only valid until the next call to next(), or
+// until the reader is destroyed. Any that are needed for longer must be copied.
+//
+// The line list is accessed through a StreamedFile (see mappedfile.h), so a
+// compressed list is decompressed one block at a time as it is read, and also
+// needs only constant memory. open() skips the header rows at the top of the
+// list, which may then be retrieved with header(). Each call to next() then
+// parses the next row of the list into a Line or XgLine, skipping empty rows,
+// and returns false once the end of the list is reached. failed() then tells
+// whether this was really the end, or the rest of the list could not be read:
+//
+//   LineListReader <XgLine> Reader;
+//   XgLine NextLine;
+//   if (Reader.open (Filename)) {
+//     while (Reader.next (&NextLine)) { ... }
+//     if (Reader.failed ()) { ... }
+//   }
+//
+// If a row cannot be parsed, next() throws the name of the offending column,
+// exactly as createLine() does. row() then gives the number of that row in the
+// file, counting from 1 at the top of the header, for use in error messages.
+// Overloaded values are collected in diagnostics(), with the same row numbers,
+// to be reported once the list has been read.
+//
+// LineType may be any class providing wavCorr (double) and createLine (const
+// char*, const char*, ParseDiagnostics*, unsigned int), i.e. either Line or
+// XgLine.
+//
+#ifndef LINE_LIST_READER_H
+#define LINE_LIST_READER_H
+
+#include <string>
+#include <vector>
+#include "mappedfile.h"
+#include "diagnostics.h"
+#include "chunkparse.h"
+
+// The number of header rows at the top of a 'writelines' line list
+#define LLR_HEADER_ROWS 4
+
+using namespace::std;
+
+template <class LineType>
+class LineListReader {
+  public:
+    LineListReader () { RowNum = 0; WavCorr = 0.0; }
+    ~LineListReader () {}
+
+    // Opens the line list at arg1 and reads its header. Returns false if the
+    // list cannot be opened. If the list ends within the header, there will
+    // be fewer than HeaderRows header rows, and next() returns false at once.
+    bool open (string Filename, unsigned int HeaderRows = LLR_HEADER_ROWS);
+
+    // Parses the next line from the list into arg1. Returns false at the end
+    // of the list.
+    bool next (LineType *NextLine) throw (const char*);
+
+    // GET functions for the header rows and the current row number
+    const string &header (unsigned int Row) const { return Header[Row]; }
+    unsigned int numHeaderRows () const { return Header.size (); }
+    unsigned int row () const { return RowNum; }
+
+    // Returns true if the list could not be read to its end
+    bool failed () const { return List.failed (); }
+
+    // Returns the overloads found in the rows read so far
+    const ParseDiagnostics &diagnostics () const { return Diagnostics; }
+
+    // Sets the wavenumber correction to be applied to each line read
+    void wavCorr (double NewCorr) { WavCorr = NewCorr; }
+
+  private:
+    StreamedFile List;
+    unsigned int RowNum;
+    vector <string> Header;
+    double WavCorr;
+    ParseDiagnostics Diagnostics;
+    ChunkStrings <LineType> Strings;
+};
+
+
+//------------------------------------------------------------------------------
+// open (string, unsigned int) : Opens the line list at arg1 and stores the arg2
+// header rows at its top.
+//
+template <class LineType>
+bool LineListReader <LineType>::open (string Filename, unsigned int HeaderRows) {
+  const char *Row, *RowEnd;
+  Header.clear ();
+  Diagnostics.clear ();
+  RowNum = 0;
+  if (!List.open (Filename)) return false;
+  for (unsigned int i = 0; i < HeaderRows; i ++) {
+    if (!List.nextRow (&Row, &RowEnd)) break;
+    Header.push_back (string (Row, RowEnd));
+    RowNum ++;
+  }
+  return true;
+}
+
+
+//------------------------------------------------------------------------------
+// next (LineType *) : Parses the next non-empty row of the line list into the
+// line at arg1, applying the wavenumber correction. Returns false, leaving arg1
+// unchanged, if there are no more rows. The strings of the line read by the
+// previous call are discarded.
+//
+template <class LineType>
+bool LineListReader <LineType>::next (LineType *NextLine) throw (const char*) {
+  const char *Row, *RowEnd;
+  while (List.nextRow (&Row, &RowEnd)) {
+    RowNum ++;
+    if (RowEnd != Row) {
+      NextLine -> wavCorr (WavCorr);
+      Strings.clear ();
+      Strings.createLine (*NextLine, Row, RowEnd, &Diagnostics, RowNum);
+      return true;
+    }
+  }
+  return false;
+}
+
+#endif // LINE_LIST_READER_H
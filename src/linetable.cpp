@@ -0,0 +1,192 @@
+// Xgtools
+// Copyright (C) M. P. Ruffoni 2011-2015
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// BasicLineTable class template (linetable.cpp)
+//==============================================================================
+
+#include "linetable.h"
+#include <cmath>
+
+//------------------------------------------------------------------------------
+// Line vector constructor : Creates a table holding each Line in the vector at
+// arg1, in the same order.
+//
+template <class Precision>
+BasicLineTable <Precision>::BasicLineTable (const vector <Line> &Lines) {
+  WavenumberCorrection = 0.0;
+  assign (Lines);
+}
+
+
+//------------------------------------------------------------------------------
+// clear () : Removes all the lines from the table. The wavenumber correction is
+// left unchanged.
+//
+template <class Precision>
+void BasicLineTable <Precision>::clear () {
+  Index.clear (); Itn.clear (); H.clear ();
+  Wavenumber.clear (); Peak.clear (); Width.clear (); Dmp.clear ();
+  EqWidth.clear (); EpsTot.clear (); EpsEvn.clear (); EpsOdd.clear ();
+  EpsRan.clear (); Wavelength.clear (); Tags.clear (); Id.clear ();
+  IdPool.clear (); IdLookup.clear ();
+}
+
+
+//------------------------------------------------------------------------------
+// reserve (unsigned int) : Reserves space in every column for arg1 lines.
+//
+template <class Precision>
+void BasicLineTable <Precision>::reserve (unsigned int NumLines) {
+  Index.reserve (NumLines); Itn.reserve (NumLines); H.reserve (NumLines);
+  Wavenumber.reserve (NumLines); Peak.reserve (NumLines);
+  Width.reserve (NumLines); Dmp.reserve (NumLines);
+  EqWidth.reserve (NumLines); EpsTot.reserve (NumLines);
+  EpsEvn.reserve (NumLines); EpsOdd.reserve (NumLines);
+  EpsRan.reserve (NumLines); Wavelength.reserve (NumLines);
+  Tags.reserve (NumLines); Id.reserve (NumLines);
+}
+
+
+//------------------------------------------------------------------------------
+// addLine (const Line &) : Appends the properties of the Line at arg1 to the end
+// of each column. The uncorrected properties are stored, so that the table's
+// own wavenumber correction may be applied to them.
+//
+template <class Precision>
+void BasicLineTable <Precision>::addLine (const Line &NewLine) {
+  Index.push_back (NewLine.Index);
+  Itn.push_back (NewLine.Itn);
+  H.push_back (NewLine.H);
+  Wavenumber.push_back (NewLine.Wavenumber);
+  Peak.push_back (NewLine.Peak);
+  Width.push_back (NewLine.Width);
+  Dmp.push_back (NewLine.Dmp);
+  EqWidth.push_back (NewLine.EqWidth);
+  EpsTot.push_back (NewLine.EpsTot);
+  EpsEvn.push_back (NewLine.EpsEvn);
+  EpsOdd.push_back (NewLine.EpsOdd);
+  EpsRan.push_back (NewLine.EpsRan);
+  Wavelength.push_back (NewLine.Wavelength);
+  Tags.push_back (NewLine.Tags);
+  Id.push_back (internId (NewLine.Identification));
+}
+
+
+//------------------------------------------------------------------------------
+// getLine (unsigned int) : Returns a Line holding the properties of the line in
+// row arg1, with the table's wavenumber correction.
+//
+template <class Precision>
+Line BasicLineTable <Precision>::getLine (unsigned int Row) const {
+  Line NextLine;
+  NextLine.Index = Index[Row];
+  NextLine.Itn = Itn[Row];
+  NextLine.H = H[Row];
+  NextLine.Wavenumber = Wavenumber[Row];
+  NextLine.Peak = Peak[Row];
+  NextLine.Width = Width[Row];
+  NextLine.Dmp = Dmp[Row];
+  NextLine.EqWidth = EqWidth[Row];
+  NextLine.EpsTot = EpsTot[Row];
+  NextLine.EpsEvn = EpsEvn[Row];
+  NextLine.EpsOdd = EpsOdd[Row];
+  NextLine.EpsRan = EpsRan[Row];
+  NextLine.Wavelength = Wavelength[Row];
+  NextLine.Tags = Tags[Row];
+  NextLine.id (IdPool[Id[Row]]);
+  NextLine.WavenumberCorrection = WavenumberCorrection;
+  return NextLine;
+}
+
+
+//------------------------------------------------------------------------------
+// assign (const vector <Line> &) : Replaces the contents of the table with each
+// Line in the vector at arg1, in the same order. The table takes its wavenumber
+// correction from the first Line in the vector.
+//
+template <class Precision>
+void BasicLineTable <Precision>::assign (const vector <Line> &Lines) {
+  clear ();
+  if (!Lines.empty ()) WavenumberCorrection = Lines[0].wavCorr ();
+  reserve (Lines.size ());
+  for (unsigned int i = 0; i < Lines.size (); i ++) {
+    addLine (Lines[i]);
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// toLines (vector <Line> *) : Replaces the contents of the vector at arg1 with
+// a Line for every line in the table, in the same order.
+//
+template <class Precision>
+void BasicLineTable <Precision>::toLines (vector <Line> *Lines) const {
+  Lines -> clear ();
+  Lines -> reserve (size ());
+  for (unsigned int i = 0; i < size (); i ++) {
+    Lines -> push_back (getLine (i));
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// internId (const string &) : Returns the position of the identification at
+// arg1 in IdPool. New identifications are appended to the pool.
+//
+template <class Precision>
+unsigned int BasicLineTable <Precision>::internId (const string &NewId) {
+  map <string, unsigned int>::iterator Found = IdLookup.find (NewId);
+  if (Found != IdLookup.end ()) return Found -> second;
+  IdPool.push_back (NewId);
+  IdLookup.insert (make_pair (NewId, (unsigned int)(IdPool.size () - 1)));
+  return IdPool.size () - 1;
+}
+
+
+
+//------------------------------------------------------------------------------
+// BasicLineView getCentroidError (unsigned int, double) : Returns the centroid
+// error of the line in row arg1 of the viewed table, calculated exactly as in
+// Line::getCentroidError() with a data point spacing of arg2.
+//
+template <class Precision>
+double BasicLineView <Precision>::getCentroidError (unsigned int Row,
+  double PointSpacing) const {
+  double Width = Table -> Width[Row];
+  double PointsInFwhm = Width / (1000.0 * PointSpacing);
+  return Width / (1000.0 * sqrt (PointsInFwhm) * Table -> Peak[Row]);
+}
+
+
+//------------------------------------------------------------------------------
+// BasicLineView operator[] (unsigned int) : Returns a Line holding the 
+// properties of the line in row arg1 of the viewed table, with the view's
+// wavenumber correction.
+//
+template <class Precision>
+Line BasicLineView <Precision>::operator[] (unsigned int Row) const {
+  Line NextLine = Table -> getLine (Row);
+  NextLine.wavCorr (WavenumberCorrection);
+  return NextLine;
+}
+
+// The table is only ever used in these two precisions, so both are compiled
+// here, with their views, rather than in every file that uses a table.
+template class BasicLineTable <DoublePrecision>;
+template class BasicLineTable <SinglePrecision>;
+template class BasicLineView <DoublePrecision>;
+template class BasicLineView <SinglePrecision>;
@@ -0,0 +1,193 @@
+// Xgtools
+// Copyright (C) M. P. Ruffoni 2011-2015
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// BasicLineTable and BasicLineView class templates (linetable.h)
+//==============================================================================
+// Stores a complete line list column by column, rather than as a vector of
+// Line objects. Each line property is held in its own contiguous array, so a
+// loop that only needs, say, the wavenumbers of the lines reads nothing but
+// wavenumbers from memory. This is the form in which ListCal holds its line
+// lists, as the calibration only ever looks at a few properties of each line.
+//
+// The line identifications are interned. Each distinct identification is
+// stored only once, in IdPool, and the ID column holds the position of each
+// line's identification in the pool.
+//
+// Lines are referred to by their position (row) in the table, and each GET
+// function takes the row of the line to be read as its argument. As in Line,
+// the wavenumber correction is applied to those properties that require it.
+// All the lines in a line list share a single wavenumber correction, so there
+// is only one correction for the whole table, set with wavCorr(double).
+//
+// A LineTable may be converted to and from Line objects with addLine(),
+// getLine(), and the vector <Line> constructor, assign() and toLines(). A Line
+// taken from a table is identical to the Line that was added to it, except
+// that its air correction and intensity calibration are always zero, as
+// these are not used in line list files.
+//
+// The precision in which the line properties are stored is set by the
+// Precision template parameter, which is one of the policies in precision.h.
+// The GET functions always return doubles, whatever the storage precision. A
+// BasicLineTable of either precision may be used directly, but Xgtools itself
+// uses LineTable, the table with the precision chosen at compile time. Only
+// LineTable can be read from or written to a cache file.
+//
+// A BasicLineView presents the lines of an existing table as if they had a
+// different wavenumber correction, without copying or modifying the table.
+// The corrected properties are calculated only as each is read, so a view of a
+// table of any size costs no more than a pointer and the correction. Indexing
+// a view, View[Row], gives a Line exactly as getLine() would, but with the
+// view's correction, so a view can be written out by the same code that
+// writes a vector <Line>. LineView is the view of a LineTable.
+//
+#ifndef LINE_TABLE_H
+#define LINE_TABLE_H
+
+#include <vector>
+#include <string>
+#include <map>
+#include "line.h"
+#include "precision.h"
+
+using namespace::std;
+
+template <class Precision> class BasicLineView;
+
+template <class Precision>
+class BasicLineTable {
+  public:
+    // The type in which the line properties, except the wavenumber and
+    // wavelength, are stored
+    typedef typename Precision::Real Real;
+
+    BasicLineTable () { WavenumberCorrection = 0.0; }
+    BasicLineTable (const vector <Line> &Lines);
+    ~BasicLineTable () {}
+
+    // Table size functions. These behave as their std::vector counterparts.
+    unsigned int size () const { return Wavenumber.size (); }
+    bool empty () const { return Wavenumber.empty (); }
+    void clear ();
+    void reserve (unsigned int NumLines);
+
+    // GET functions to access the properties of the line in row arg1. Apply
+    // the wavenumber correction to any properties that require it.
+    int line (unsigned int Row) const { return Index[Row]; }
+    int itn (unsigned int Row) const { return Itn[Row]; }
+    int h (unsigned int Row) const { return H[Row]; }
+    double wavenumber (unsigned int Row) const
+      { return Wavenumber[Row] * (1.0 + WavenumberCorrection); }
+    double peak (unsigned int Row) const { return Peak[Row]; }
+    double width (unsigned int Row) const
+      { return Width[Row] * (1.0 + WavenumberCorrection); }
+    double dmp (unsigned int Row) const { return Dmp[Row]; }
+    double eqwidth (unsigned int Row) const { return EqWidth[Row]; }
+    double epstot (unsigned int Row) const { return EpsTot[Row]; }
+    double epsevn (unsigned int Row) const { return EpsEvn[Row]; }
+    double epsodd (unsigned int Row) const { return EpsOdd[Row]; }
+    double epsran (unsigned int Row) const { return EpsRan[Row]; }
+    double wavelength (unsigned int Row) const
+      { return Wavelength[Row] / (1.0 + WavenumberCorrection); }
+    char tags (unsigned int Row) const { return Tags[Row]; }
+    const string &id (unsigned int Row) const { return IdPool[Id[Row]]; }
+    double wavCorr () const { return WavenumberCorrection; }
+
+    // SET function for the wavenumber correction of the whole table
+    void wavCorr (double NewCorr) { WavenumberCorrection = NewCorr; }
+
+    // Conversion to and from Line objects. addLine() appends a Line to the end
+    // of the table, and getLine() returns a copy of the line in row arg1.
+    // assign() replaces the table contents with the Lines in a vector, taking
+    // the table's wavenumber correction from the first of them.
+    void addLine (const Line &NewLine);
+    Line getLine (unsigned int Row) const;
+    void assign (const vector <Line> &Lines);
+    void toLines (vector <Line> *Lines) const;
+
+    // Returns the number of distinct line identifications in the table.
+    unsigned int numIds () const { return IdPool.size (); }
+
+  private:
+    // The cache file functions copy whole columns to and from the table. See
+    // linecache.cpp.
+    friend class LineCacheColumns;
+
+    // A view reads the uncorrected columns to apply its own correction.
+    friend class BasicLineView <Precision>;
+
+    // The line property columns, named as in Line.
+    vector <int> Index, Itn, H;
+    vector <double> Wavenumber, Wavelength;
+    vector <Real> Peak, Width, Dmp, EqWidth, EpsTot, EpsEvn, EpsOdd, EpsRan;
+    vector <char> Tags;
+    vector <unsigned int> Id;
+    double WavenumberCorrection;
+
+    // The interned line identifications. IdLookup maps each identification to
+    // its position in IdPool.
+    vector <string> IdPool;
+    map <string, unsigned int> IdLookup;
+
+    // Returns the position of arg1 in IdPool, adding it to the pool if needed.
+    unsigned int internId (const string &NewId);
+};
+
+// The line table used throughout Xgtools, in the precision chosen at compile
+// time. See precision.h.
+typedef BasicLineTable <LinePrecision> LineTable;
+
+
+template <class Precision>
+class BasicLineView {
+  public:
+    // Creates a view of the table at arg1 with the wavenumber correction at
+    // arg2. The table must outlive the view.
+    BasicLineView (const BasicLineTable <Precision> &Lines, double NewCorr)
+      { Table = &Lines; WavenumberCorrection = NewCorr; }
+    ~BasicLineView () {}
+
+    unsigned int size () const { return Table -> size (); }
+    bool empty () const { return Table -> empty (); }
+
+    // GET functions for the line in row arg1, as in BasicLineTable, but with
+    // the view's wavenumber correction.
+    int line (unsigned int Row) const { return Table -> line (Row); }
+    double wavenumber (unsigned int Row) const
+      { return Table -> Wavenumber[Row] * (1.0 + WavenumberCorrection); }
+    double width (unsigned int Row) const
+      { return Table -> Width[Row] * (1.0 + WavenumberCorrection); }
+    double wavelength (unsigned int Row) const
+      { return Table -> Wavelength[Row] / (1.0 + WavenumberCorrection); }
+    double wavCorr () const { return WavenumberCorrection; }
+
+    // Returns Line::getCentroidError() for the line in row arg1. This uses the
+    // uncorrected width, as Line does.
+    double getCentroidError (unsigned int Row, 
+      double PointSpacing = DEF_POINT_SPACING) const;
+
+    // Returns a copy of the line in row arg1 with the view's correction
+    Line operator[] (unsigned int Row) const;
+
+  private:
+    const BasicLineTable <Precision> *Table;
+    double WavenumberCorrection;
+};
+
+// The view of a LineTable
+typedef BasicLineView <LinePrecision> LineView;
+
+#endif // LINE_TABLE_H
@@ -18,8 +18,10 @@
 #include <fstream>
 #include <sstream>
 #include <cmath>
+#include <algorithm>
 #include "listcal.h"
-#include "lineio.cpp"
+#include "parallel.h"
+#include "linefollower.cpp"
 
 //------------------------------------------------------------------------------
 // Default class constructor. Just set default variable values.
@@ -30,12 +32,20 @@ ListCal::ListCal () {
   PeakAmpThreshold = DEF_PEAK_THRESHOLD;
   DiscardLimit = DEF_DISCARD_LIMIT;
   PointSpacing = DEF_POINT_SPACING;
+  FitMethod = DEF_FIT_METHOD;
+  NumResamples = DEF_NUM_RESAMPLES;
+  ResampleSeed = DEF_RESAMPLE_SEED;
+  Resampled.NumBootstrap = Resampled.NumJackknife = 0;
   LineListName = "";
   StandardListName = "";
+  LineList = &FullLineList;
+  StandardList = &LoadedStandardList;
+  StandardIndex = &LoadedStandardIndex;
   DiffMean = 0.0;
   DiffStdDev = 0.0;
   DiffStdErr = 0.0;
   WaveCorrectionError = 0.0;
+  ReducedChiSq = 0.0;
 }
 
 
@@ -78,68 +88,241 @@ void ListCal::setPointSpacing (double NewPointSpacing) {
   PointSpacing = NewPointSpacing;
 }
 
+void ListCal::setFitMethod (int NewFitMethod) {
+  FitMethod = NewFitMethod;
+}
+
+void ListCal::setNumResamples (unsigned int NewNumResamples) {
+  NumResamples = NewNumResamples;
+}
+
+void ListCal::setResampleSeed (unsigned long NewSeed) {
+  ResampleSeed = NewSeed;
+}
+
 //------------------------------------------------------------------------------
 // Line list loading procedures. The actual file input is carried out in 
-// readLineList(). The other two procedures, loadLineList and loadStandardList,
-// act as wrappers so that the correct Line vector is passed to readLineList().
-// These wrappers also store the list names in the class object.
+// readLineList(). The other procedures, loadLineList and loadStandardList,
+// act as wrappers so that the correct LineTable and header are passed to
+// readLineList(). These wrappers also store the list names in the class object.
+// loadLists() reads both lists at once, each on its own thread.
 //
 void ListCal::loadLineList (const char *Filename) {
-  readLineList (Filename, &FullLineList);
+  readLineList (Filename, &FullLineList, &LineListHeader);
   LineListName = Filename;
+  LineList = &FullLineList;
 }
 
 void ListCal::loadStandardList (const char *Filename) {
-  readLineList (Filename, &StandardList);
+  readLineList (Filename, &LoadedStandardList, &StandardListHeader);
   StandardListName = Filename;
+  indexStandardList ();
+}
+
+// A ParallelTask that reads one of the line lists in the ListLoadJob array at
+// arg2. As a task must not throw, any error is stored in the job instead.
+static void loadListTask (unsigned int TaskNum, void *Data) {
+  ListLoadJob *Job = (ListLoadJob*) Data + TaskNum;
+  try {
+    readLineList (Job -> Filename, Job -> Lines, Job -> Header);
+  } catch (int Err) {
+    Job -> Err = Err;
+  }
+}
+
+void ListCal::loadLists (const char *LineFilename, 
+  const char *StandardFilename) {
+  ListLoadJob Jobs [2] = {
+    { LineFilename, &FullLineList, &LineListHeader, LC_NO_ERROR },
+    { StandardFilename, &LoadedStandardList, &StandardListHeader, LC_NO_ERROR } };
+  runParallel (2, loadListTask, Jobs, 2);
+  if (Jobs[0].Err != LC_NO_ERROR) throw int (Jobs[0].Err);
+  if (Jobs[1].Err != LC_NO_ERROR) throw int (Jobs[1].Err);
+  LineListName = LineFilename;
+  StandardListName = StandardFilename;
+  LineList = &FullLineList;
+  indexStandardList ();
+}
+
+
+//------------------------------------------------------------------------------
+// followLineList (const char *) : Reads the uncalibrated line list at arg1
+// through a LineListFollower, rather than readLineList(), so that any lines
+// later appended to the list can be added with updateLineList(). The list may
+// still be empty, or lack some of its header, if it is still being written.
+//
+void ListCal::followLineList (const char *Filename) {
+  Follower.open (Filename);
+  Follower.poll (&FullLineList, &LineListHeader);
+  LineListName = Filename;
+  LineList = &FullLineList;
+}
+
+
+//------------------------------------------------------------------------------
+// updateLineList (unsigned int) : Waits up to arg1 milliseconds for lines to be
+// appended to the list opened with followLineList(), and adds any that have
+// been to the uncalibrated line list. Returns the number of lines added. The
+// lines must then be matched and fitted again, starting from findCommonLines().
+//
+unsigned int ListCal::updateLineList (unsigned int Timeout) {
+  Follower.wait (Timeout);
+  unsigned int NumLinesAdded = Follower.poll (&FullLineList, &LineListHeader);
+  if (Follower.reset ()) {
+    cout << LineListName << " has been replaced. Reading it again from the "
+      << "start." << endl;
+  }
+  return NumLinesAdded;
+}
+
+
+//------------------------------------------------------------------------------
+// Orderings used by findCommonLines(). WavenumberOrder compares the rows of a
+// LineTable by wavenumber, or a row with a wavenumber, for sorting and
+// searching an index of the table. closerMatch() orders candidate LineMatches
+// by the difference in wavenumber, breaking ties by row so that the matching
+// never depends on the sort.
+//
+typedef struct td_WavenumberOrder {
+  const LineTable *Table;
+  bool operator() (unsigned int Row1, unsigned int Row2) const
+    { return Table -> wavenumber (Row1) < Table -> wavenumber (Row2); }
+  bool operator() (unsigned int Row, double Wavenumber) const
+    { return Table -> wavenumber (Row) < Wavenumber; }
+} WavenumberOrder;
+
+static bool closerMatch (const LineMatch &Match1, const LineMatch &Match2) {
+  if (Match1.Difference != Match2.Difference) 
+    return Match1.Difference < Match2.Difference;
+  if (Match1.Pair.List != Match2.Pair.List) 
+    return Match1.Pair.List < Match2.Pair.List;
+  return Match1.Pair.Standard < Match2.Pair.Standard;
+}
+
+static bool listOrder (const LinePair &Pair1, const LinePair &Pair2) {
+  return Pair1.List < Pair2.List;
+}
+
+
+//------------------------------------------------------------------------------
+// indexStandardList () : Sorts the rows of the standard list just loaded by
+// wavenumber into LoadedStandardIndex, so that findCommonLines() can search the
+// standard list however its lines are ordered, and makes the loaded list and
+// index the ones used. Called whenever the standard list is loaded.
+//
+void ListCal::indexStandardList () {
+  WavenumberOrder ByWavenumber = { &LoadedStandardList };
+  LoadedStandardIndex.resize (LoadedStandardList.size ());
+  for (unsigned int i = 0; i < LoadedStandardIndex.size (); i ++) {
+    LoadedStandardIndex[i] = i;
+  }
+  stable_sort (LoadedStandardIndex.begin (), LoadedStandardIndex.end (), 
+    ByWavenumber);
+  StandardList = &LoadedStandardList;
+  StandardIndex = &LoadedStandardIndex;
+}
+
+
+//------------------------------------------------------------------------------
+// shareStandardList (const ListCal &) : Uses the standard list, and its index,
+// already loaded by the ListCal at arg1, rather than loading a copy. Any number
+// of ListCal objects may share one standard list in this way, even from
+// different threads, as the list is only ever read. The ListCal at arg1 must
+// outlive this one, and must not load another standard list while it is
+// shared.
+//
+void ListCal::shareStandardList (const ListCal &Reference) {
+  StandardList = Reference.StandardList;
+  StandardIndex = Reference.StandardIndex;
+  StandardListHeader = Reference.StandardListHeader;
+  StandardListName = Reference.StandardListName;
+}
+
+
+//------------------------------------------------------------------------------
+// shareLineList (const ListCal &) : Uses the uncalibrated line list already
+// loaded by the ListCal at arg1, rather than loading a copy, so that the same
+// list may be calibrated in several ways at once. As for shareStandardList(),
+// the ListCal at arg1 must outlive this one, and must not load another list
+// while it is shared.
+//
+void ListCal::shareLineList (const ListCal &Reference) {
+  LineList = Reference.LineList;
+  LineListHeader = Reference.LineListHeader;
+  LineListName = Reference.LineListName;
 }
 
 
 //------------------------------------------------------------------------------
-// findCommonLines (bool) ; Scans through the uncalibrated and standard line
-// lists, searching for lines common to both. When a common line is found, a new
-// LinePair is created with pointers to its location in each of the two lists.
-// This is then pushed onto the CommonLines class vector.
+// findCommonLines (bool) ; Searches the uncalibrated and standard line lists
+// for lines common to both. Neither list need be sorted. For each uncalibrated
+// line, every standard line within Discriminator of it is found by a binary
+// search of the StandardIndex, and each becomes a candidate LineMatch. The
+// candidates are then taken in order of increasing wavenumber difference, and
+// each is accepted only if neither of its lines has already been matched, so
+// a line with several possible partners is paired with the closest that is
+// not closer to another line. Each accepted match becomes a LinePair, holding
+// the line's row in each of the two lists, and these are stored in the
+// CommonLines class vector in the order of the uncalibrated list. The whole
+// search takes O((N + M) log M) time for lists of N and M lines, provided
+// that few lines have more than one candidate.
 //
 void ListCal::findCommonLines (bool Verbose) {
-  unsigned int ListIndex = 0;
-  unsigned int StdIndex = 0;
-  double Difference;
-  LinePair NewLinePair;
+  WavenumberOrder ByWavenumber = { StandardList };
+  vector <LineMatch> Candidates;
+  LineMatch NewMatch;
 
-  if (FullLineList.size () == 0 || StandardList.size () == 0) {
+  if (LineList -> size () == 0 || StandardList -> size () == 0) {
     throw int (LC_NO_DATA);
   }
-  
+
+  // Find every standard line within Discriminator of each uncalibrated line
+  for (unsigned int i = 0; i < LineList -> size (); i ++) {
+    double Wavenumber = LineList -> wavenumber (i);
+    vector <unsigned int>::const_iterator Std = lower_bound (
+      StandardIndex -> begin (), StandardIndex -> end (), 
+      Wavenumber - Discriminator, ByWavenumber);
+    for ( ; Std != StandardIndex -> end (); Std ++) {
+      double Difference = StandardList -> wavenumber (*Std) - Wavenumber;
+      if (Difference >= Discriminator) break;
+      if (abs(Difference) < Discriminator) {
+        NewMatch.Pair.List = i;
+        NewMatch.Pair.Standard = *Std;
+        NewMatch.Difference = abs(Difference);
+        Candidates.push_back (NewMatch);
+      }
+    }
+  }
+
+  // Accept the closest candidates first, so that each line is matched at most
+  // once, and to its closest available partner.
+  sort (Candidates.begin (), Candidates.end (), closerMatch);
+  vector <bool> ListMatched (LineList -> size (), false);
+  vector <bool> StdMatched (StandardList -> size (), false);
+  CommonLines.clear ();
+  for (unsigned int i = 0; i < Candidates.size (); i ++) {
+    const LinePair &Pair = Candidates[i].Pair;
+    if (ListMatched [Pair.List] || StdMatched [Pair.Standard]) continue;
+    ListMatched [Pair.List] = true;
+    StdMatched [Pair.Standard] = true;
+    CommonLines.push_back (Pair);
+  }
+  sort (CommonLines.begin (), CommonLines.end (), listOrder);
+
   if (Verbose) { 
     cout << "Lines common to both experimental and reference line lists." << endl;
     cout << "Index" << '\t' << "Wavenumber (K)" << '\t' << "Peak Height" << '\t' << "Ref Wavenumber (K)" << endl;
-  }
-  CommonLines.clear ();
-  while (ListIndex < FullLineList.size () && StdIndex < StandardList.size ()) {
-    Difference = 
-      StandardList[StdIndex].wavenumber() - FullLineList[ListIndex].wavenumber();
-    if (abs(Difference) < Discriminator) {
-      // A common line has been found.
-      NewLinePair.List = &FullLineList[ListIndex];
-      NewLinePair.Standard = &StandardList[StdIndex];
-      CommonLines.push_back (NewLinePair);
-      if (Verbose) { 
-        cout << NewLinePair.List -> line() << '\t' << NewLinePair.List -> wavenumber() << '\t' << '\t'
-          << NewLinePair.List -> peak() << '\t' << '\t' << NewLinePair.Standard -> wavenumber() << endl;
-      }
-      StdIndex ++;
-      ListIndex ++;
-    } else if (StandardList[StdIndex].wavenumber() < FullLineList[ListIndex].wavenumber()) {
-      // One of the standard lines is missing from the experiment
-      if (Verbose) {
-        cout << "Reference line " << StandardList[StdIndex].line() << " (" 
-          << StandardList[StdIndex].wavenumber() << "K) is absent from the experiment." << endl;
+    for (unsigned int i = 0; i < CommonLines.size (); i ++) {
+      cout << LineList -> line (CommonLines[i].List) << '\t' 
+        << LineList -> wavenumber (CommonLines[i].List) << '\t' << '\t'
+        << LineList -> peak (CommonLines[i].List) << '\t' << '\t' 
+        << StandardList -> wavenumber (CommonLines[i].Standard) << endl;
+    }
+    for (unsigned int i = 0; i < StandardIndex -> size (); i ++) {
+      if (!StdMatched [(*StandardIndex)[i]]) {
+        cout << "Reference line " << StandardList -> line ((*StandardIndex)[i]) << " (" 
+          << StandardList -> wavenumber ((*StandardIndex)[i]) << "K) is absent from the experiment." << endl;
       }
-      StdIndex ++;
-    } else {
-      // One of the experiment lines is missing from the standard
-      ListIndex ++;
     }
   }
   if (CommonLines.size () == 0) { 
@@ -153,7 +336,9 @@ void ListCal::findCommonLines (bool Verbose) {
 // findFittedLines (bool) : Takes the list of lines that are common to both
 // input line lists and creates a sub-list from the lines of amplitude greater
 // than or equal to PeakAmpThreshold. These are the lines that will subsequently
-// be fitted, hence they are stored in FittedLines.
+// be fitted, hence they are stored in FittedLines. Any lines discarded from an
+// earlier fit are forgotten, as the fit must now start again. The running sums
+// used by the fit, Sums, are started from the new FittedLines.
 //
 void ListCal::findFittedLines (bool Verbose) {
   if (CommonLines.size () == 0) { throw int (LC_NO_DATA); }
@@ -166,13 +351,14 @@ void ListCal::findFittedLines (bool Verbose) {
     cout << fixed;
   }
   FittedLines.clear ();
+  DiscardedLines.clear ();
   for (unsigned int i = 0; i < CommonLines.size (); i ++) {
-    if (CommonLines[i].List -> peak() >= PeakAmpThreshold) {
+    if (LineList -> peak (CommonLines[i].List) >= PeakAmpThreshold) {
       FittedLines.push_back (&CommonLines [i]);
       if (Verbose) { 
-        cout.precision (0); cout << CommonLines[i].List -> line() << '\t';
-        cout.precision (6); cout << CommonLines[i].List -> wavenumber() << '\t';
-        cout.precision (2); cout << CommonLines[i].List -> peak() << endl;
+        cout.precision (0); cout << LineList -> line (CommonLines[i].List) << '\t';
+        cout.precision (6); cout << LineList -> wavenumber (CommonLines[i].List) << '\t';
+        cout.precision (2); cout << LineList -> peak (CommonLines[i].List) << endl;
       }
     }
   }
@@ -180,6 +366,28 @@ void ListCal::findFittedLines (bool Verbose) {
     cout.unsetf (ios_base::fixed);
     cout.precision (6);
     cout << "------------------------------------------" << endl << endl;
+  if (FittedLines.size () == 0) {
+    cout << "Error: None of the common lines has an amplitude of " 
+      << PeakAmpThreshold << " or greater." << endl;
+    throw int (LC_NO_DATA);
+  }
+
+  // Start the running sums over the fitted lines. These are then updated as
+  // lines are removed, rather than summed again for every fit.
+  vector <double> Diffs (FittedLines.size ());
+  for (unsigned int i = 0; i < FittedLines.size (); i ++) {
+    Diffs[i] = relativeDiff (FittedLines[i]);
+  }
+  nth_element (Diffs.begin (), Diffs.begin () + Diffs.size () / 2, Diffs.end ());
+  Sums.Offset = Diffs [Diffs.size () / 2];
+  Sums.Sum = 0.0;
+  Sums.SumSq = 0.0;
+  Sums.NumLines = FittedLines.size ();
+  for (unsigned int i = 0; i < FittedLines.size (); i ++) {
+    double d = relativeDiff (FittedLines[i]) - Sums.Offset;
+    Sums.Sum += d;
+    Sums.SumSq += d * d;
+  }
 }
 
 
@@ -189,26 +397,58 @@ void ListCal::findFittedLines (bool Verbose) {
 // DiscardLimit * DiffStdDev. This function should be called after 
 // findCalibration() so as to check the quality of the Wavenumber correction.
 //
+// The residual of every fitted line is found first, and compared with the
+// limit in a separate loop with no branches, which the compiler can vectorise.
+// FittedLines is then compacted in a single pass, keeping the remaining lines
+// in order. The discarded lines are reported and added to DiscardedLines last
+// first, as they always have been, and each is subtracted from the running
+// sums, so that the next fit need not sum over the remaining lines again.
+//
 int ListCal::removeBadLines (bool Verbose) {
-  double Difference = 0.0;
-  int LinesRemoved = 0;
-  for (int i = (int)FittedLines.size () - 1; i >= 0; i --) {
-    Difference = (FittedLines[i] -> List-> wavenumber() * (1.0 + WaveCorrection) -
-      FittedLines[i] -> Standard -> wavenumber()) * LC_DATA_SCALE;
-    Difference /= FittedLines[i]->Standard->wavenumber();
-    if (abs(Difference) > abs(DiffMean) + DiscardLimit * DiffStdDev) {
-      if (Verbose) {
-        cout << "Removing line " << FittedLines[i] -> List -> line() 
-          << ": " << FittedLines[i] -> List -> wavenumber()
-          << "K\t(residual dSig/Sig = " << Difference / LC_DATA_SCALE << ", limit = +/-" 
-          << (DiffMean + DiscardLimit * DiffStdDev) / LC_DATA_SCALE << ")" << endl;
-      }
-      DiscardedLines.push_back (FittedLines[i]);
-      FittedLines.erase (FittedLines.begin() + i);
-      LinesRemoved ++; 
+  const unsigned int NumLines = FittedLines.size ();
+  const double Limit = abs(DiffMean) + DiscardLimit * DiffStdDev;
+  vector <double> Difference (NumLines);
+  vector <char> Keep (NumLines);
+  vector <LinePair*> Rejects;
+  vector <double> RejectDifference;
+
+  // Find the residual of each line, and whether it lies within the limit
+  for (unsigned int i = 0; i < NumLines; i ++) {
+    double Std = StandardList -> wavenumber (FittedLines[i] -> Standard);
+    Difference[i] = (LineList -> wavenumber (FittedLines[i] -> List) 
+      * (1.0 + WaveCorrection) - Std) * LC_DATA_SCALE / Std;
+  }
+  for (unsigned int i = 0; i < NumLines; i ++) {
+    Keep[i] = !(fabs (Difference[i]) > Limit);
+  }
+
+  // Move the lines to be kept to the front of FittedLines, in order, and set
+  // the others aside
+  unsigned int NumKept = 0;
+  for (unsigned int i = 0; i < NumLines; i ++) {
+    if (Keep[i]) {
+      FittedLines[NumKept ++] = FittedLines[i];
+    } else {
+      Rejects.push_back (FittedLines[i]);
+      RejectDifference.push_back (Difference[i]);
     }
   }
-  return LinesRemoved;
+  FittedLines.resize (NumKept);
+
+  for (int i = (int)Rejects.size () - 1; i >= 0; i --) {
+    if (Verbose) {
+      cout << "Removing line " << LineList -> line (Rejects[i] -> List) 
+        << ": " << LineList -> wavenumber (Rejects[i] -> List)
+        << "K\t(residual dSig/Sig = " << RejectDifference[i] / LC_DATA_SCALE << ", limit = +/-" 
+        << (DiffMean + DiscardLimit * DiffStdDev) / LC_DATA_SCALE << ")" << endl;
+    }
+    double d = relativeDiff (Rejects[i]) - Sums.Offset;
+    Sums.Sum -= d;
+    Sums.SumSq -= d * d;
+    Sums.NumLines --;
+    DiscardedLines.push_back (Rejects[i]);
+  }
+  return Rejects.size ();
 }
 
 
@@ -227,17 +467,89 @@ int ListCal::printLineList (vector <Line> LineList) {
 
 
 //------------------------------------------------------------------------------
-// findCorrection () : Uses a GSL Levenberg-Marquardt algorithm to fit the lines
-// in FittedLines to the wavenumbers in the user-specified calibration standard.
-// The result is the optimal wavenumber correction factor for the uncalibrated
-// data, which is stored in the class variable WaveCorrection. Information about
-// the fit residuals are saved by calling calcDiffStats().
+// findCorrection () : Fits the lines in FittedLines to the wavenumbers in the
+// user-specified calibration standard. The result is the optimal wavenumber
+// correction factor for the uncalibrated data, which is stored in the class
+// variable WaveCorrection. The fit is done by fitCorrectionLinear() or, if
+// selected with setFitMethod(), by fitCorrectionGsl(). Information about the
+// fit residuals are saved by calling calcDiffStats(). If Verbose is true, the
+// fit results are printed. Any results from resampleCorrection() are cleared,
+// as they no longer describe the fit.
 //
-void ListCal::findCorrection () {
+void ListCal::findCorrection (bool Verbose) {
+  const size_t NumParameters = 1;
+  const size_t NumLines = FittedLines.size ();
+  double Chi, Err;
+  if (FitMethod == FIT_METHOD_GSL) {
+    fitCorrectionGsl (&Chi, &Err);
+  } else {
+    fitCorrectionLinear (&Chi, &Err);
+  }
+
+  // Scale the error in the fit parameter by the fit residuals, and output the
+  // results.
+  double dof = NumLines - double(NumParameters);
+  double c = Chi / sqrt (dof);
+  WaveCorrectionError = c*Err;
+  ReducedChiSq = pow(Chi, 2) / dof;
+  calcDiffStats ();
+  Resampled.NumBootstrap = Resampled.NumJackknife = 0;
+  if (Verbose) {
+    cout << "Correction factor: " << WaveCorrection << " +/- " << c*Err << " ("
+      << "reduced chi^2 = " << ReducedChiSq << ", "
+      << "lines fitted = " << NumLines << ", c = " << c << ")" << endl;
+    cout << "dSig/Sig Mean Residual: " << DiffMean / LC_DATA_SCALE 
+      << ", StdDev: " << DiffStdDev / LC_DATA_SCALE
+      << ", StdErr: " << DiffStdErr / LC_DATA_SCALE << endl;
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// fitCorrectionLinear (double *, double *) : Finds the wavenumber correction by
+// linear least squares. Each line's residual, as in fitFn(), is its wavenumber
+// difference from the standard, weighted by 1 / \sigma_{std,i}, i.e.
+//
+//   f_i = LC_DATA_SCALE * (r_i * (1 + WaveCorrection) - 1)
+//
+// where r_i = \sigma_i / \sigma_{std,i}. As r_i is always very close to 1, the
+// fit is linearised with the same constant Jacobian, LC_DATA_SCALE, as given by
+// derivFn(). The chi^2 minimum is then where the residuals sum to zero, i.e.
+//
+//   1 + WaveCorrection = N / sum (r_i)
+//
+// which is found directly rather than iteratively, and is the point to which
+// fitCorrectionGsl() converges. Writing d_i = r_i - 1, the residuals are
+// f_i = LC_DATA_SCALE * (1 + WaveCorrection) * (d_i - mean (d_i)), so chi^2
+// follows from the variance of d_i. Both are found from the running sums of
+// d_i, so the fit takes the same time however many lines are fitted. The
+// correction is stored in
+// WaveCorrection, chi (the norm of the residuals) in arg1, and the unscaled
+// error in the correction, sqrt(covariance), in arg2.
+//
+void ListCal::fitCorrectionLinear (double *Chi, double *Err) {
+  const double N = Sums.NumLines;
+  double MeanD = Sums.Offset + Sums.Sum / N;
+  double Scale = 1.0 / (1.0 + MeanD);
+  WaveCorrection = - MeanD * Scale;
+  *Chi = LC_DATA_SCALE * Scale 
+    * sqrt (max (Sums.SumSq - Sums.Sum * Sums.Sum / N, 0.0));
+  *Err = 1.0 / (LC_DATA_SCALE * sqrt (N));
+}
+
+
+//------------------------------------------------------------------------------
+// fitCorrectionGsl (double *, double *) : Finds the wavenumber correction with
+// a GSL Levenberg-Marquardt algorithm, starting from the current value of
+// WaveCorrection. This is slower than fitCorrectionLinear(), but could equally
+// fit a model that is non-linear in its parameters. The results are returned
+// as by fitCorrectionLinear().
+//
+void ListCal::fitCorrectionGsl (double *Chi, double *Err) {
 
   // Prepare the GSL Solver and associated objects. A non-linear solver is used,
   // the precise type of which is determined by SOLVER_TYPE, defined in 
-  // MgstFcn.h. 
+  // listcal.h. 
   const size_t NumParameters = 1;
   const size_t NumLines = FittedLines.size ();
   
@@ -249,13 +561,17 @@ void ListCal::findCorrection () {
   gsl_multifit_function_fdf FitFunction;
   gsl_matrix *Covariance = gsl_matrix_alloc (NumParameters, NumParameters);
   gsl_vector_view VectorView = gsl_vector_view_array (GuessArr, NumParameters);
+  FitData Data;
+  Data.List = LineList;
+  Data.Standard = StandardList;
+  Data.Lines = &FittedLines;
 
   FitFunction.f = &fitFn;
   FitFunction.df = &derivFn;
   FitFunction.fdf = &fitAndDerivFns;
   FitFunction.n = NumLines;
   FitFunction.p = NumParameters;
-  FitFunction.params = &FittedLines;
+  FitFunction.params = &Data;
  
   SolverType = SOLVER_TYPE;
   Solver = gsl_multifit_fdfsolver_alloc(SolverType, NumLines, NumParameters);
@@ -274,27 +590,11 @@ void ListCal::findCorrection () {
     Status = gsl_multifit_test_delta (Solver->dx, Solver->x, SOLVER_TOL, SOLVER_TOL);
   } while (Status == GSL_CONTINUE && Iteration < SOLVER_MAX_ITERATIONS);
 
-  // Output all the fit parameters with their associated error.
+  // Return the fit parameter with its associated error.
   gsl_multifit_covar (Solver -> J, 0.0, Covariance);
-#define FIT(i) gsl_vector_get (Solver -> x, i)
-#define ERR(i) sqrt (gsl_matrix_get (Covariance, i, i))
-
-  double chi = gsl_blas_dnrm2 (Solver -> f);
-  double dof = NumLines - double(NumParameters);
-  double c = chi / sqrt (dof);
-  
-  cout << "Correction factor: " << FIT(0) << " +/- " << c*ERR(0) << " ("
-    << "reduced chi^2 = " << pow(chi, 2) / dof << ", "
-    << "lines fitted = " << NumLines << ", c = " << c << ")" << endl;
-
-  // Apply the wavenumber correction to all the lines loaded from the
-  // uncalibrated spectrum
-  WaveCorrection = FIT(0);
-  WaveCorrectionError = c*ERR(0);
-  calcDiffStats ();
-  cout << "dSig/Sig Mean Residual: " << DiffMean / LC_DATA_SCALE 
-    << ", StdDev: " << DiffStdDev / LC_DATA_SCALE
-    << ", StdErr: " << DiffStdErr / LC_DATA_SCALE << endl;
+  WaveCorrection = gsl_vector_get (Solver -> x, 0);
+  *Err = sqrt (gsl_matrix_get (Covariance, 0, 0));
+  *Chi = gsl_blas_dnrm2 (Solver -> f);
 
   // Clean up the memory and exit
   gsl_multifit_fdfsolver_free (Solver);
@@ -307,148 +607,266 @@ void ListCal::findCorrection () {
 // and standard error, after the application of the wavenumber correction factor
 // stored in 'WaveCorrection'. These are stored in the class variables DiffMean,
 // DiffStdDev, and DiffStdErr, respectively. calcDiffStats is called at the end
-// of findCorrection().
+// of findCorrection(). The difference of each line, in units of dSig/Sig /
+// LC_DATA_SCALE, is (1 + WaveCorrection) * (1 + d) - 1, with d as in
+// FitSums, so the statistics follow from the running sums of d without
+// visiting the lines themselves.
 //
 void ListCal::calcDiffStats () {
-  DiffMean = 0.0;
-  DiffStdDev = 0.0;
-  double Difference = 0.0;
-  for (unsigned int i = 0; i < FittedLines.size (); i ++) {
-    Difference = (FittedLines[i] -> List -> wavenumber() * (1.0 + WaveCorrection)
-      - FittedLines[i] -> Standard -> wavenumber()) * LC_DATA_SCALE;
-    Difference /= FittedLines[i]->Standard->wavenumber();
-    DiffMean += Difference;
+  const double N = Sums.NumLines;
+  double MeanD = Sums.Offset + Sums.Sum / N;
+  double VarD = max (Sums.SumSq - Sums.Sum * Sums.Sum / N, 0.0) / N;
+  DiffMean = (WaveCorrection + MeanD + WaveCorrection * MeanD) * LC_DATA_SCALE;
+  DiffStdDev = (1.0 + WaveCorrection) * sqrt (VarD) * LC_DATA_SCALE;
+  DiffStdErr = DiffStdDev / sqrt (N);
+}
+
+
+//------------------------------------------------------------------------------
+// relativeDiff (const LinePair *) : Returns the fractional difference between
+// the uncalibrated and standard wavenumbers of the line pair at arg1.
+//
+double ListCal::relativeDiff (const LinePair *Pair) const {
+  double Std = StandardList -> wavenumber (Pair -> Standard);
+  return (LineList -> wavenumber (Pair -> List) - Std) / Std;
+}
+
+
+//------------------------------------------------------------------------------
+// bootstrapTask (unsigned int, void *) : A ParallelTask that fits the
+// wavenumber correction to one block of LC_RESAMPLE_BLOCK bootstrap resamples
+// of the lines in the BootstrapData at arg2. Each resample draws as many lines
+// as were fitted, with replacement, from a random number stream seeded by the
+// task number, and is fitted as by fitCorrectionLinear().
+//
+static void bootstrapTask (unsigned int TaskNum, void *Data) {
+  BootstrapData *Boot = (BootstrapData*) Data;
+  const vector <double> &Diffs = *Boot -> Diffs;
+  const unsigned long N = Diffs.size ();
+  unsigned int First = TaskNum * LC_RESAMPLE_BLOCK;
+  unsigned int Last = min (First + LC_RESAMPLE_BLOCK, Boot -> NumResamples);
+  gsl_rng *Rng = gsl_rng_alloc (gsl_rng_mt19937);
+  gsl_rng_set (Rng, Boot -> Seed + TaskNum);
+  for (unsigned int i = First; i < Last; i ++) {
+    double Sum = 0.0;
+    for (unsigned long j = 0; j < N; j ++) {
+      Sum += Diffs[gsl_rng_uniform_int (Rng, N)];
+    }
+    double MeanD = Boot -> Offset + Sum / N;
+    Boot -> Corrections[i] = - MeanD / (1.0 + MeanD);
   }
-  DiffMean /= FittedLines.size ();
+  gsl_rng_free (Rng);
+}
 
-  for (unsigned int i = 0; i < FittedLines.size (); i ++) {
-    Difference = (FittedLines[i] -> List -> wavenumber() * (1.0 + WaveCorrection)
-      - FittedLines[i] -> Standard -> wavenumber()) * LC_DATA_SCALE;
-    Difference /= FittedLines[i]->Standard->wavenumber();
-    DiffStdDev += pow (Difference - DiffMean, 2);
+
+//------------------------------------------------------------------------------
+// percentile (const vector <double> &, double) : Returns the value below which
+// the fraction arg2 of the sorted values at arg1 lie, interpolating linearly
+// between neighbouring values.
+//
+static double percentile (const vector <double> &Sorted, double Fraction) {
+  double Position = Fraction * (Sorted.size () - 1);
+  unsigned int Below = (unsigned int) Position;
+  if (Below + 1 >= Sorted.size ()) return Sorted.back ();
+  return Sorted[Below] + (Position - Below) * (Sorted[Below + 1] - Sorted[Below]);
+}
+
+
+//------------------------------------------------------------------------------
+// resampleCorrection (bool) : Estimates the uncertainty in the wavenumber
+// correction from the spread of the corrections fitted to resamples of the
+// FittedLines, rather than from the fit covariance. A bootstrap of
+// NumResamples resamples is run in parallel, and a jackknife of every fit that
+// leaves out one line. The results are stored in Resampled, and are saved by
+// saveLineList(). If Verbose is true, they are also printed. Nothing is done if
+// NumResamples is zero or fewer than two lines are fitted.
+//
+// Each resample is fitted in closed form, as by fitCorrectionLinear(), to
+// which fitCorrectionGsl() also converges, so only d for each fitted line is
+// needed. The leave-one-out fits follow directly from the sum of d.
+//
+void ListCal::resampleCorrection (bool Verbose) {
+  const unsigned int N = FittedLines.size ();
+  Resampled.NumBootstrap = Resampled.NumJackknife = 0;
+  if (NumResamples == 0 || N < 2) return;
+  vector <double> Diffs (N);
+  double Sum = 0.0;
+  for (unsigned int i = 0; i < N; i ++) {
+    Diffs[i] = relativeDiff (FittedLines[i]) - Sums.Offset;
+    Sum += Diffs[i];
+  }
+
+  // Fit each bootstrap resample, then find the mean, standard deviation and
+  // percentile intervals of the fitted corrections
+  vector <double> Corrections (NumResamples);
+  BootstrapData Boot;
+  Boot.Diffs = &Diffs;
+  Boot.Offset = Sums.Offset;
+  Boot.Seed = ResampleSeed;
+  Boot.NumResamples = NumResamples;
+  Boot.Corrections = &Corrections[0];
+  runParallel ((NumResamples + LC_RESAMPLE_BLOCK - 1) / LC_RESAMPLE_BLOCK, 
+    bootstrapTask, &Boot);
+  double Mean = 0.0, SumSq = 0.0;
+  for (unsigned int i = 0; i < NumResamples; i ++) Mean += Corrections[i];
+  Mean /= NumResamples;
+  for (unsigned int i = 0; i < NumResamples; i ++) {
+    SumSq += (Corrections[i] - Mean) * (Corrections[i] - Mean);
+  }
+  sort (Corrections.begin (), Corrections.end ());
+  Resampled.NumBootstrap = NumResamples;
+  Resampled.BootstrapMean = Mean;
+  Resampled.BootstrapStdDev = NumResamples > 1 ? sqrt (SumSq / (NumResamples - 1)) : 0.0;
+  Resampled.Lower1 = percentile (Corrections, 0.5 - LC_INTERVAL_1 / 2.0);
+  Resampled.Upper1 = percentile (Corrections, 0.5 + LC_INTERVAL_1 / 2.0);
+  Resampled.Lower2 = percentile (Corrections, 0.5 - LC_INTERVAL_2 / 2.0);
+  Resampled.Upper2 = percentile (Corrections, 0.5 + LC_INTERVAL_2 / 2.0);
+
+  // Fit each jackknife sample, leaving out line i, and compare them with the
+  // fit to every line
+  double MeanD = Sums.Offset + Sum / N;
+  double Full = - MeanD / (1.0 + MeanD);
+  for (unsigned int i = 0; i < N; i ++) {
+    MeanD = Sums.Offset + (Sum - Diffs[i]) / (N - 1);
+    Diffs[i] = - MeanD / (1.0 + MeanD);
+  }
+  Mean = 0.0;
+  SumSq = 0.0;
+  for (unsigned int i = 0; i < N; i ++) Mean += Diffs[i];
+  Mean /= N;
+  for (unsigned int i = 0; i < N; i ++) {
+    SumSq += (Diffs[i] - Mean) * (Diffs[i] - Mean);
+  }
+  Resampled.NumJackknife = N;
+  Resampled.JackknifeBias = (N - 1) * (Mean - Full);
+  Resampled.JackknifeStdErr = sqrt (SumSq * (N - 1) / N);
+
+  if (Verbose) {
+    cout << "Bootstrap dSig/Sig: " << Resampled.BootstrapMean << " +/- " 
+      << Resampled.BootstrapStdDev << " (" << NumResamples << " resamples)" << endl;
+    cout << "  " << LC_INTERVAL_1 * 100.0 << "% interval: " << Resampled.Lower1 
+      << " to " << Resampled.Upper1 << endl;
+    cout << "  " << LC_INTERVAL_2 * 100.0 << "% interval: " << Resampled.Lower2 
+      << " to " << Resampled.Upper2 << endl;
+    cout << "Jackknife dSig/Sig bias: " << Resampled.JackknifeBias 
+      << ", StdErr: " << Resampled.JackknifeStdErr << " (" << N << " fits)" << endl;
   }
-  DiffStdDev = sqrt (DiffStdDev / FittedLines.size ());
-  DiffStdErr = DiffStdDev / sqrt (FittedLines.size());
 }
 
 
 //------------------------------------------------------------------------------
-// plotDifferences () : Uses Gnuplot to plot the FittedLines and DiscardedLines.
-// Output is first to the screen, and then to the postscipt file Calibration.ps.
+// gnuplotString (const char *) : Returns the string at arg1 as a double-quoted
+// Gnuplot string. Any '"' or '\' is escaped, as are line breaks, so that a
+// filename given by the user can neither end the string early nor start a new
+// command in the script.
 //
-void ListCal::plotDifferences () {
-  FILE *gpPipe, *tempFittedFile, *tempDiscardedFile;
-  string tempFitted, tempDiscarded;
-  double x, y;
-  tempFitted = "tempFitted";
-  tempDiscarded = "tempDiscarded";
-  gpPipe = popen("/usr/bin/gnuplot","w");
-  if (gpPipe) {
-    // Prepare the Gnuplot graph and label the axes
-    fprintf(gpPipe, "set termoption enhanced\n");
-    fprintf(gpPipe, "set xlabel \"Line Wavenumber / cm^{-1}\" \n");
-    fprintf(gpPipe, "set ylabel \"dSig/Sig x %1.0e\" \n", LC_DATA_SCALE);
-//    fprintf(gpPipe, "set title \"Wavenumber correction factors for each line.\\nOptimal correction = %1.3e \u00B1 %1.3e\"\n",
-//      WaveCorrection, WaveCorrectionError);
-
-    // Find the optimal y axis scale and fix the y axis to this scale once done.
-    // This must be done before finding the optimal x-axis scale as the dummy
-    // points for the std-dev markers will lie outside the optimal x range.
-    fprintf(gpPipe, "set yrange [] writeback\n");
-    fprintf(gpPipe, "plot \"%s\" lt rgb \"#0000FF\" t \"Fitted Lines (%i)\", \
-      \"%s\" lt rgb \"#FF0000\" t \"Discarded Lines (%i)\", \
-      \"\" u (48480.):(%1.3e):(0):(100000) w xerror notitle ps 0 lt 0 lw 0.5 lc rgb \"#909090\", \
-      \"\" u (48480.):(%1.3e):(0):(100000) w xerror notitle ps 0 lt 0 lw 0.5 lc rgb \"#909090\"\n", 
-      tempFitted.c_str(), FittedLines.size(), tempDiscarded.c_str(), 
-      DiscardedLines.size(), DiffStdDev * DiscardLimit - WaveCorrection * LC_DATA_SCALE, 
-      -1.0 * DiffStdDev * DiscardLimit - WaveCorrection * LC_DATA_SCALE);
-    fprintf(gpPipe, "set yrange restore\n");
-
-    // Find the optimal x axis scale by plotting the Fitted and Discarded data
-    // points only. Fix the x axis to this scale once done.
-    fprintf(gpPipe, "set xrange [] writeback\n");
-    if (DiscardedLines.size () > 0) {
-      fprintf(gpPipe, "plot \"%s\" lt rgb \"#0000FF\" t \"Fitted Lines (%i)\", \
-        \"%s\" lt rgb \"#FF0000\" t \"Discarded Lines (%i)\"\n",
-        tempFitted.c_str(), FittedLines.size(), tempDiscarded.c_str(), 
-        DiscardedLines.size());
-    } else {
-      fprintf(gpPipe, "plot \"%s\" lt rgb \"#0000FF\" t \"Fitted Lines (%i)\"\n",
-        tempFitted.c_str(), FittedLines.size());
-    }
-    fprintf(gpPipe, "set xrange restore\n");
-    fprintf(gpPipe, "set style line 1 lt 2 lw 1 lc rgb \"#000000\"\n");
-    fprintf(gpPipe, "set key box linestyle 1\n");
-    
-    // Finally, plot the real data again, but also add two dummy points with
-    // huge x errors to denote the cutoff lines between Fitted and Discarded
-    // lines.
-    fprintf(gpPipe, "plot \"%s\" lt rgb \"#0000FF\" t \"Fitted Lines (%i)\", \
-      \"%s\" lt rgb \"#FF0000\" t \"Discarded Lines (%i)\", \
-      \"\" u (48480.):(%1.3e):(0):(100000) w xerror notitle ps 0 lt 0 lw 0.5 lc rgb \"#909090\", \
-      \"\" u (48480.):(%1.3e):(0):(100000) w xerror notitle ps 0 lt 0 lw 0.5 lc rgb \"#909090\"\n", 
-      tempFitted.c_str(), FittedLines.size(), tempDiscarded.c_str(), 
-      DiscardedLines.size(), DiffStdDev * DiscardLimit - WaveCorrection * LC_DATA_SCALE, 
-      -1.0 * DiffStdDev * DiscardLimit - WaveCorrection * LC_DATA_SCALE);
-    fflush(gpPipe);
-    
-    // Now generate two temporary files containing the data points for Gnuplot
-    // to plot - one for the FittedLines, and a second for the DiscardedLines.
-    // If the temporary files cannot be created, throw an error to the user.
-    tempFittedFile = fopen(tempFitted.c_str(),"w");
-    if (!tempFittedFile) {
-      cout << "Error: Cannot create Gnuplot temporary file " << tempFitted 
-      << ".\nCheck you have write access to the current directory. Plotting ABORTED." << endl;
-      throw int (LC_FILE_OPEN_ERROR);
-    }
-    for (unsigned i = 0; i < FittedLines.size (); i ++) {
-      x = FittedLines[i] -> Standard -> wavenumber();
-      y = (FittedLines[i] -> List -> wavenumber() /** (1.0 + WaveCorrection)*/
-        - FittedLines[i] -> Standard -> wavenumber()) * LC_DATA_SCALE;
-      y /= FittedLines[i]->Standard->wavenumber();
-      fprintf(tempFittedFile,"%1.12e %1.12e\n", x, y);
+static string gnuplotString (const char *Text) {
+  string Quoted = "\"";
+  for (const char *c = Text; *c; c ++) {
+    switch (*c) {
+      case '"': Quoted += "\\\""; break;
+      case '\\': Quoted += "\\\\"; break;
+      case '\n': Quoted += "\\n"; break;
+      case '\r': Quoted += "\\r"; break;
+      default: Quoted += *c;
     }
-    tempDiscardedFile = fopen(tempDiscarded.c_str(),"w");
-    if (!tempDiscardedFile) {
-      cout << "Error: Cannot create Gnuplot temporary file " << tempDiscarded 
-      << ".\nCheck you have write access to the current directory. Plotting ABORTED." << endl;
-      throw int (LC_FILE_OPEN_ERROR);
-    }
-    if (DiscardedLines.size () > 0) {
-      for (unsigned i = 0; i < DiscardedLines.size (); i ++) {
-        x = DiscardedLines[i] -> Standard -> wavenumber();
-        y = (DiscardedLines[i] -> List -> wavenumber() /** (1.0 + WaveCorrection)*/
-          - DiscardedLines[i] -> Standard -> wavenumber()) * LC_DATA_SCALE;
-        y /= DiscardedLines[i]->Standard->wavenumber();
-        fprintf(tempDiscardedFile,"%1.12e %1.12e\n", x, y);
-      }
-    } else {
-      fprintf(tempDiscardedFile, "0.0 0.0\n");
-    }
-    fclose(tempFittedFile);
-    fclose(tempDiscardedFile);
+  }
+  return Quoted + "\"";
+}
+
 
+//------------------------------------------------------------------------------
+// plotDifferences (const char *) : Uses Gnuplot to plot the FittedLines and
+// DiscardedLines. If arg1 is NULL, output is first to the screen and then, once
+// the user presses enter, to the postscript file LC_PLOT_PS_FILE. Otherwise,
+// the plot is saved straight to the file at arg1, as PNG if its name ends in
+// LC_PLOT_PNG_EXTENSION or as SVG if not, with nothing shown on screen and no
+// wait for the user. In either case, the data are passed to Gnuplot through
+// the pipe, so no temporary files are written.
+//
+void ListCal::plotDifferences (const char *Filename) {
+  FILE *gpPipe = popen(LC_GNUPLOT, "w");
+  if (!gpPipe) {
+    printf("gnuplot not found...");
+    throw int (LC_PLOT_NO_GNUPLOT);
+  }
+
+  // Prepare the Gnuplot graph and label the axes
+  fprintf(gpPipe, "set termoption enhanced\n");
+  fprintf(gpPipe, "set xlabel \"Line Wavenumber / cm^{-1}\" \n");
+  fprintf(gpPipe, "set ylabel \"dSig/Sig x %1.0e\" \n", LC_DATA_SCALE);
+  fprintf(gpPipe, "set style line 1 lt 2 lw 1 lc rgb \"#000000\"\n");
+  fprintf(gpPipe, "set key box linestyle 1\n");
+  if (Filename) {
+    
+    // Render the plot directly to the requested file
+    string Name = Filename;
+    string Extension = LC_PLOT_PNG_EXTENSION;
+    bool Png = Name.size () >= Extension.size () 
+      && Name.compare (Name.size () - Extension.size (), Extension.size (), 
+      Extension) == 0;
+    fprintf(gpPipe, "set terminal %s\n", 
+      Png ? LC_PLOT_PNG_TERMINAL : LC_PLOT_SVG_TERMINAL);
+    fprintf(gpPipe, "set output %s\n", gnuplotString (Filename).c_str ());
+    plotResiduals (gpPipe);
+  } else {
+  
     // Wait for the user to finish with the on-screen graph, then save the plot
-    // to 'Calibration.ps', discard the temp files, and shut down Gnuplot.
+    // to LC_PLOT_PS_FILE. The data must be sent again, as Gnuplot cannot replot
+    // data read from the pipe.
+    plotResiduals (gpPipe);
     printf("press enter to continue...");          
     getchar();
-
     fprintf(gpPipe, "set size 0.9, 0.5\n");
     fprintf(gpPipe, "set terminal postscript portrait enhanced color solid lw 1 \"Times\" 11\n");
-    fprintf(gpPipe, "set output \"Calibration.ps\"\n");
-    fprintf(gpPipe, "replot\n");
-    fprintf(gpPipe,"exit \n");
-    pclose(gpPipe);
-    
-    remove(tempFitted.c_str());
-    remove(tempDiscarded.c_str());
-  } else {
-    printf("gnuplot not found...");
-    throw int (LC_PLOT_NO_GNUPLOT);
-  }     
+    fprintf(gpPipe, "set output \"%s\"\n", LC_PLOT_PS_FILE);
+    plotResiduals (gpPipe);
+  }
+  fprintf(gpPipe,"exit \n");
+  pclose(gpPipe);
 }  
 
 
+//------------------------------------------------------------------------------
+// plotResiduals (FILE *) : Sends a plot command for the residuals of the
+// FittedLines and DiscardedLines, followed by the data themselves, to the
+// Gnuplot pipe at arg1. The discard limits are drawn as constant functions,
+// so that they are included when Gnuplot autoscales the y axis, while the x
+// axis is scaled to the lines alone.
+//
+void ListCal::plotResiduals (FILE *gpPipe) {
+  fprintf(gpPipe, "plot \"-\" lt rgb \"#0000FF\" t \"Fitted Lines (%i)\", ", 
+    (int) FittedLines.size());
+  if (DiscardedLines.size () > 0) {
+    fprintf(gpPipe, "\"-\" lt rgb \"#FF0000\" t \"Discarded Lines (%i)\", ", 
+      (int) DiscardedLines.size());
+  }
+  fprintf(gpPipe, "%1.3e notitle lt 0 lw 0.5 lc rgb \"#909090\", \
+    %1.3e notitle lt 0 lw 0.5 lc rgb \"#909090\"\n", 
+    DiffStdDev * DiscardLimit - WaveCorrection * LC_DATA_SCALE, 
+    -1.0 * DiffStdDev * DiscardLimit - WaveCorrection * LC_DATA_SCALE);
+  plotLines (gpPipe, FittedLines);
+  if (DiscardedLines.size () > 0) plotLines (gpPipe, DiscardedLines);
+  fflush(gpPipe);
+}
+
+
+//------------------------------------------------------------------------------
+// plotLines (FILE *, const vector <LinePair*> &) : Sends the wavenumber and 
+// uncorrected residual of each line pair at arg2 to the Gnuplot pipe at arg1,
+// as the inline data for one plot.
+//
+void ListCal::plotLines (FILE *gpPipe, const vector <LinePair*> &Lines) {
+  double x, y;
+  for (unsigned i = 0; i < Lines.size (); i ++) {
+    x = StandardList -> wavenumber (Lines[i] -> Standard);
+    y = relativeDiff (Lines[i]) * LC_DATA_SCALE;
+    fprintf(gpPipe, "%1.12e %1.12e\n", x, y);
+  }
+  fprintf(gpPipe, "e\n");
+}
+
+
 //------------------------------------------------------------------------------
 // saveLineList (const char *Filename) : Produces a calibrated line list in the
 // XGremlin writelines format and a calibration results files. The latter
@@ -456,19 +874,16 @@ void ListCal::plotDifferences () {
 // numbers with all the associated error components.
 //
 int ListCal::saveLineList (const char *Filename) {
-  if (FullLineList.size () == 0) { return LC_NO_DATA; }
+  if (LineList -> size () == 0) { return LC_NO_DATA; }
   ostringstream oss;
   oss.str ("");
   oss << Filename << ".cln";
 
   // First save the calibrated line list to an XGremlin writelines formatted
-  // file. Work on a copy of the FullLineList so as not to modify its wavcorr.
-  vector <Line> SavedLines;
-  for (unsigned int i = 0; i < FullLineList.size (); i ++) {
-    SavedLines.push_back (FullLineList[i]);
-    SavedLines[i].wavCorr (getWaveCorrection ());
-  }
-  writeLines (SavedLines, oss.str().c_str());
+  // file. Write it through a view of the LineList with the new correction,
+  // so as not to modify or copy the list itself.
+  LineView SavedLines (*LineList, getWaveCorrection ());
+  writeLines (SavedLines, LineListHeader, oss.str());
 
   // Now prepare to save the calibration results themselves.
   oss.str ("");
@@ -489,7 +904,18 @@ int ListCal::saveLineList (const char *Filename) {
   fprintf (LineFile, "# Point Spacing     : %f\n#\n", PointSpacing);
   fprintf (LineFile, "# Correction factor : %e +/- %e\n", WaveCorrection, WaveCorrectionError);
   fprintf (LineFile, "# Mean fit residual : %e\n", DiffMean / LC_DATA_SCALE);
-  fprintf (LineFile, "# Residual std dev  : %e\n#\n", DiffStdDev / LC_DATA_SCALE);
+  fprintf (LineFile, "# Residual std dev  : %e\n", DiffStdDev / LC_DATA_SCALE);
+  if (Resampled.NumBootstrap > 0) {
+    fprintf (LineFile, "# Bootstrap mean    : %e +/- %e (%u resamples)\n", 
+      Resampled.BootstrapMean, Resampled.BootstrapStdDev, Resampled.NumBootstrap);
+    fprintf (LineFile, "# Bootstrap %4.1f%%   : %e to %e\n", 
+      LC_INTERVAL_1 * 100.0, Resampled.Lower1, Resampled.Upper1);
+    fprintf (LineFile, "# Bootstrap %4.1f%%   : %e to %e\n", 
+      LC_INTERVAL_2 * 100.0, Resampled.Lower2, Resampled.Upper2);
+    fprintf (LineFile, "# Jackknife std err : %e (bias %e, %u fits)\n", 
+      Resampled.JackknifeStdErr, Resampled.JackknifeBias, Resampled.NumJackknife);
+  }
+  fprintf (LineFile, "#\n");
   fprintf (LineFile, "#  n  Wavenumber    Scale Error   StdDev Error  Brault Error  Full Error\n");
 
   // Output the calibrated wavenumber for each line, the individual error
@@ -497,15 +923,17 @@ int ListCal::saveLineList (const char *Filename) {
   FullErrorStdDev = sqrt (pow (getWaveCorrectionError (), 2) 
     + pow (DiffStdDev / LC_DATA_SCALE, 2));
   for (unsigned int i = 0; i < SavedLines.size (); i ++) {
-    FullErrorBrault = sqrt (pow (SavedLines[i].wavenumber() * getWaveCorrectionError (), 2) 
-      + pow (SavedLines[i].getCentroidError (PointSpacing), 2));
+    double Wavenumber = SavedLines.wavenumber (i);
+    double CentroidError = SavedLines.getCentroidError (i, PointSpacing);
+    FullErrorBrault = sqrt (pow (Wavenumber * getWaveCorrectionError (), 2) 
+      + pow (CentroidError, 2));
     fprintf (LineFile, "%4d  %11.6f  %11.6e  %11.6e  %11.6e  %11.6e\n", 
-      SavedLines[i].line(),
-      SavedLines[i].wavenumber(),
-      SavedLines[i].wavenumber() * getWaveCorrectionError (),
-      SavedLines[i].wavenumber() * DiffStdDev / LC_DATA_SCALE,
-      SavedLines[i].getCentroidError (PointSpacing),
-      max (SavedLines[i].wavenumber() * FullErrorStdDev, FullErrorBrault));
+      SavedLines.line (i),
+      Wavenumber,
+      Wavenumber * getWaveCorrectionError (),
+      Wavenumber * DiffStdDev / LC_DATA_SCALE,
+      CentroidError,
+      max (Wavenumber * FullErrorStdDev, FullErrorBrault));
   }
   fclose (LineFile);
   return LC_NO_ERROR;
@@ -521,11 +949,13 @@ int ListCal::saveLineList (const char *Filename) {
 //
 int fitFn (const gsl_vector *x, void *data, gsl_vector *f) {
   double Step = gsl_vector_get (x, 0);
-  vector <LinePair*> *FittedLines = (vector <LinePair*> *) data;  
-  for (unsigned int i = 0; i < FittedLines->size (); i ++) {
-    gsl_vector_set (f, i, (FittedLines->at(i)->List->wavenumber() * (1.0 + Step) 
-      - FittedLines->at(i)->Standard->wavenumber()) * LC_DATA_SCALE 
-      / FittedLines->at(i)->Standard->wavenumber());
+  FitData *Data = (FitData *) data;
+  const vector <LinePair*> &FittedLines = *Data -> Lines;
+  for (unsigned int i = 0; i < FittedLines.size (); i ++) {
+    gsl_vector_set (f, i, 
+      (Data -> List -> wavenumber (FittedLines[i] -> List) * (1.0 + Step) 
+      - Data -> Standard -> wavenumber (FittedLines[i] -> Standard)) 
+      * LC_DATA_SCALE / Data -> Standard -> wavenumber (FittedLines[i] -> Standard));
   }
   return GSL_SUCCESS;
 }
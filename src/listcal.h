@@ -19,13 +19,18 @@
 
 #include <vector>
 #include <string>
+#include <cstdio>
 #include <gsl/gsl_vector.h>
 #include <gsl/gsl_blas.h>
 #include <gsl/gsl_multifit_nlin.h>
 #include <gsl/gsl_math.h>
 #include <gsl/gsl_deriv.h>
+#include <gsl/gsl_rng.h>
 #include "ErrDefs.h"
 #include "line.h"
+#include "linetable.h"
+#include "linefollower.h"
+#include "writelinesheader.h"
 
 // Default spectrum processing parameters
 #define DEF_WAVE_CORRECTION 0.0  /* wavenumbers                               */
@@ -35,6 +40,25 @@
 
 // Output parameters
 #define LC_DATA_SCALE   1.0e6    /* scale the output amplitude by this factor */
+#define LC_GNUPLOT      "/usr/bin/gnuplot"
+#define LC_PLOT_PS_FILE "Calibration.ps"
+#define LC_PLOT_PNG_EXTENSION ".png"
+#define LC_PLOT_SVG_TERMINAL "svg enhanced size 900,500 font \"Times,11\""
+#define LC_PLOT_PNG_TERMINAL "pngcairo enhanced size 900,500 font \"Times,11\""
+
+// Methods by which findCorrection() may fit the wavenumber correction
+#define FIT_METHOD_LINEAR 0      /* closed-form linear least squares          */
+#define FIT_METHOD_GSL    1      /* GSL Levenberg-Marquardt solver            */
+#define DEF_FIT_METHOD    FIT_METHOD_LINEAR
+
+// Resampling parameters. The bootstrap resamples are drawn in blocks of
+// LC_RESAMPLE_BLOCK, each from its own random number stream, so that the
+// results depend only on the seed and not on the number of threads.
+#define DEF_NUM_RESAMPLES   0     /* bootstrap resamples, or 0 for none       */
+#define DEF_RESAMPLE_SEED   1
+#define LC_RESAMPLE_BLOCK   256
+#define LC_INTERVAL_1       0.6827 /* central fractions of the bootstrap      */
+#define LC_INTERVAL_2       0.95   /* distribution given as intervals         */
 
 // GSL Fitting parameters
 #define SOLVER_TYPE gsl_multifit_fdfsolver_lmsder
@@ -46,12 +70,78 @@ using namespace::std;
 
 // Define a structure in which a matched pair of lines can be stored. One of
 // these will come from the uncalibrated list, the other from the calibration
-// standard.
+// standard. Each is stored as its row in the LineTable holding that list.
 typedef struct td_LinePair {
-  Line *List;
-  Line *Standard;
+  unsigned int List;
+  unsigned int Standard;
 } LinePair;
 
+// A candidate match between a line in the uncalibrated list and a line in the
+// standard list, found by findCommonLines(), and the absolute difference in
+// their wavenumbers.
+typedef struct td_LineMatch {
+  LinePair Pair;
+  double Difference;
+} LineMatch;
+
+// The data passed to the GSL fitting functions: the lines to be fitted, and the
+// tables holding the uncalibrated and standard line lists.
+typedef struct td_FitData {
+  const LineTable *List;
+  const LineTable *Standard;
+  const vector <LinePair*> *Lines;
+} FitData;
+
+// Running sums over the fitted lines of d = (\sigma - \sigma_{std}) / \sigma_{std},
+// from which the fit and the residual statistics are found. The sums are of
+// d - Offset, where Offset is the median d when the sums were started, so
+// that they keep their precision when lines are later subtracted.
+typedef struct td_FitSums {
+  double Offset;
+  double Sum;
+  double SumSq;
+  unsigned int NumLines;
+} FitSums;
+
+// The distributions of the wavenumber correction found by resampleCorrection().
+// Bootstrap gives the mean and standard deviation of the corrections fitted to
+// NumBootstrap resamples of the fitted lines, and the percentile intervals
+// holding the central LC_INTERVAL_1 and LC_INTERVAL_2 of them. Jackknife gives
+// the bias and standard error of the correction from the NumJackknife fits
+// that each leave out one line. Both counts are zero until resampleCorrection()
+// is called after the last fit.
+typedef struct td_ResampleStats {
+  unsigned int NumBootstrap;
+  double BootstrapMean;
+  double BootstrapStdDev;
+  double Lower1, Upper1;
+  double Lower2, Upper2;
+  unsigned int NumJackknife;
+  double JackknifeBias;
+  double JackknifeStdErr;
+} ResampleStats;
+
+// The data shared by the bootstrap tasks run by resampleCorrection(): d -
+// Offset for each fitted line, as in FitSums, the seed from which each task's
+// random number stream is made, and the array that receives the correction
+// fitted to each resample.
+typedef struct td_BootstrapData {
+  const vector <double> *Diffs;
+  double Offset;
+  unsigned long Seed;
+  unsigned int NumResamples;
+  double *Corrections;
+} BootstrapData;
+
+// A line list to be read by loadLists(): the file to read, where to store its
+// lines and header, and the error code thrown while reading it, if any.
+typedef struct td_ListLoadJob {
+  const char *Filename;
+  LineTable *Lines;
+  WritelinesHeader *Header;
+  int Err;
+} ListLoadJob;
+
 // Create the ListCal class
 class ListCal {
 public:
@@ -61,6 +151,11 @@ public:
   // File I/O functions
   void loadStandardList (const char *Filename);
   void loadLineList (const char *Filename);
+  void loadLists (const char *LineFilename, const char *StandardFilename);
+  void shareStandardList (const ListCal &Reference);
+  void shareLineList (const ListCal &Reference);
+  void followLineList (const char *Filename);
+  unsigned int updateLineList (unsigned int Timeout = LF_POLL_INTERVAL);
   int saveLineList (const char *Filename);
 
   // Class variable GET and SET functions
@@ -69,34 +164,54 @@ public:
   void setPeakAmpThreshold (double NewThreshold);
   void setDiscardLimit (double NewDiscardLimit);
   void setPointSpacing (double NewPointSpacing);
+  void setFitMethod (int NewFitMethod);
+  void setNumResamples (unsigned int NewNumResamples);
+  void setResampleSeed (unsigned long NewSeed);
   double getWaveCorrection () { return WaveCorrection; }
   double getWaveCorrectionError () { return WaveCorrectionError; }
+  double getReducedChiSq () { return ReducedChiSq; }
   double getDiscriminator () { return Discriminator; }
   double getPeakAmpThreshold () { return PeakAmpThreshold; }
   double getDiscardLimit () { return DiscardLimit; }
+  double getPointSpacing () { return PointSpacing; }
+  int getFitMethod () { return FitMethod; }
+  unsigned int getNumResamples () { return NumResamples; }
+  unsigned long getResampleSeed () { return ResampleSeed; }
+  const ResampleStats &getResampleStats () { return Resampled; }
   double getDiffMean () { return DiffMean; }
   double getDiffStdDev () { return DiffStdDev; }
   double getDiffStdErr () { return DiffStdErr; }
+  unsigned int getNumFittedLines () { return FittedLines.size (); }
+  unsigned int getNumDiscardedLines () { return DiscardedLines.size (); }
   
   // Calibration and list manipulation functions
-  void findCorrection ();
+  void findCorrection (bool Verbose = true);
   void findCommonLines (bool Verbose = false);
   void findFittedLines (bool Verbose = false);
   int removeBadLines (bool Verbose = false);
+  void resampleCorrection (bool Verbose = false);
   void calcDiffStats ();
   
   // Output functions
   int printLineList (vector <Line> LineList);
-  void plotDifferences ();
+  void plotDifferences (const char *Filename = NULL);
 
 private:
-  vector <Line> FullLineList;   // All the lines from the uncalibrated line list
-  vector <Line> StandardList;   // All the lines from the standard line list
+  LineTable FullLineList;       // All the lines from the uncalibrated line list
+  const LineTable *LineList;    // The uncalibrated list in use: that above, or shared
+  LineTable LoadedStandardList; // All the lines from the standard line list
+  WritelinesHeader LineListHeader;     // The header rows of each list
+  WritelinesHeader StandardListHeader;
+  vector <unsigned int> LoadedStandardIndex; // Its rows sorted by wavenumber
+  const LineTable *StandardList; // The standard list and index in use: either
+  const vector <unsigned int> *StandardIndex; // those above, or shared
+  LineListFollower Follower;    // Reads lines appended to the uncalibrated list
   vector <LinePair> CommonLines;  // Lines from FullLineList that exist in StandardList
   vector <LinePair*> FittedLines; // Lines from CommonLines to be fitted (weak lines omitted)
   vector <LinePair*> DiscardedLines; // Lines removed from FittedLines
   double WaveCorrection;
   double WaveCorrectionError;
+  double ReducedChiSq;
   double Discriminator;
   double PeakAmpThreshold;
   double DiscardLimit;
@@ -106,6 +221,27 @@ private:
   double DiffStdDev;
   double DiffStdErr;
   double PointSpacing;
+  int FitMethod;
+  FitSums Sums;                   // Kept up to date with FittedLines
+  unsigned int NumResamples;
+  unsigned long ResampleSeed;
+  ResampleStats Resampled;        // Reset by each findCorrection()
+
+  // The fitting methods used by findCorrection()
+  void fitCorrectionLinear (double *Chi, double *Err);
+  void fitCorrectionGsl (double *Chi, double *Err);
+
+  // Sorts the rows of LoadedStandardList by wavenumber into
+  // LoadedStandardIndex, and uses these as the standard list and its index
+  void indexStandardList ();
+
+  // Send the residual plot and its data to a Gnuplot pipe. See
+  // plotDifferences().
+  void plotResiduals (FILE *gpPipe);
+  void plotLines (FILE *gpPipe, const vector <LinePair*> &Lines);
+
+  // Returns d for the line pair at arg1. See FitSums.
+  double relativeDiff (const LinePair *Pair) const;
 };
 
 int fitFn (const gsl_vector *x, void *data, gsl_vector *f);
@@ -0,0 +1,424 @@
+// Xgtools
+// Copyright (C) M. P. Ruffoni 2011-2015
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// MappedFile class (mappedfile.cpp)
+//==============================================================================
+
+#include "mappedfile.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+// The block size used when a file cannot be mapped and must be read instead.
+#define MF_READ_BLOCK_SIZE 1048576 /* bytes */
+
+// Data points here for empty files so that begin() and end() remain valid.
+static const char EmptyFile [1] = { '\0' };
+
+// The leading bytes that identify a compressed file, and the command used to
+// decompress each type of file to the standard output. A gzip file is
+// identified by its two ID bytes and its compression method (deflate).
+typedef struct td_Compression {
+  unsigned char Magic [MF_MAGIC_LENGTH];
+  size_t MagicLength;
+  const char *Command;
+} Compression;
+
+static const Compression Compressions [] = {
+  { { 0x1f, 0x8b, 0x08 }, 3, "gzip -dc" },
+  { { 0x28, 0xb5, 0x2f, 0xfd }, 4, "zstd -dc" }
+};
+#define MF_NUM_COMPRESSIONS (sizeof (Compressions) / sizeof (Compression))
+
+
+//------------------------------------------------------------------------------
+// decompressCommand (int) : Examines the first bytes of the regular file open
+// on arg1. If these identify a compressed file, returns the command that will
+// decompress it. Otherwise, returns NULL. The file offset is not changed.
+//
+static const char *decompressCommand (int Fd) {
+  unsigned char Magic [MF_MAGIC_LENGTH];
+  ssize_t BytesRead = pread (Fd, Magic, MF_MAGIC_LENGTH, 0);
+  for (unsigned int i = 0; i < MF_NUM_COMPRESSIONS; i ++) {
+    size_t Length = Compressions[i].MagicLength;
+    if (BytesRead >= (ssize_t)Length 
+      && memcmp (Magic, Compressions[i].Magic, Length) == 0) {
+      return Compressions[i].Command;
+    }
+  }
+  return NULL;
+}
+
+
+//------------------------------------------------------------------------------
+// shellQuote (string) : Returns arg1 in single quotes, so that it is passed to
+// the shell by popen() as a single word, whatever characters it contains.
+//
+static string shellQuote (string Text) {
+  string Quoted = "'";
+  for (unsigned int i = 0; i < Text.size (); i ++) {
+    if (Text[i] == '\'') Quoted += "'\\''";
+    else Quoted += Text[i];
+  }
+  return Quoted + "'";
+}
+
+
+//------------------------------------------------------------------------------
+// readBlocks (int, char **, size_t *) : Reads from arg1 until EOF, in blocks of
+// MF_READ_BLOCK_SIZE, into a heap buffer. The buffer is returned in arg2 and
+// the number of bytes read in arg3. Returns false, having freed the buffer, if
+// the read fails.
+//
+static bool readBlocks (int Fd, char **Buffer, size_t *Used) {
+  size_t Capacity = 0;
+  ssize_t BytesRead;
+  *Buffer = 0;
+  *Used = 0;
+  do {
+    if (Capacity - *Used < MF_READ_BLOCK_SIZE) {
+      Capacity += Capacity > MF_READ_BLOCK_SIZE ? Capacity : MF_READ_BLOCK_SIZE;
+      char *NewBuffer = (char *)realloc (*Buffer, Capacity);
+      if (!NewBuffer) { free (*Buffer); *Buffer = 0; return false; }
+      *Buffer = NewBuffer;
+    }
+    BytesRead = read (Fd, *Buffer + *Used, Capacity - *Used);
+    if (BytesRead > 0) *Used += BytesRead;
+  } while (BytesRead > 0);
+  if (BytesRead < 0) { free (*Buffer); *Buffer = 0; return false; }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Default constructor : Creates a MappedFile with no file open.
+//
+MappedFile::MappedFile () {
+  Data = EmptyFile; Size = 0; Opened = false; Mapped = false;
+  Compressed = false;
+}
+
+
+//------------------------------------------------------------------------------
+// Open constructor : Creates a MappedFile and opens the file at arg1. Use
+// isOpen() to check that this was successful.
+//
+MappedFile::MappedFile (string Filename) {
+  Data = EmptyFile; Size = 0; Opened = false; Mapped = false;
+  Compressed = false;
+  open (Filename);
+}
+
+
+//------------------------------------------------------------------------------
+// open (string, bool) : Maps the file at arg1 into memory, or reads it into a
+// heap buffer if it cannot be mapped. If arg2 is true and the file is gzip or
+// zstd compressed, it is instead decompressed into the buffer. Any file already
+// open is closed first. Returns false if the file cannot be opened or read.
+//
+bool MappedFile::open (string Filename, bool Decompress) {
+  struct stat FileStat;
+  const char *Command;
+  close ();
+
+  int Fd = ::open (Filename.c_str (), O_RDONLY);
+  if (Fd < 0) return false;
+
+  // Regular files are mapped directly, unless they are compressed. There is
+  // nothing to map for an empty file, so leave Data pointing at EmptyFile.
+  if (fstat (Fd, &FileStat) == 0 && S_ISREG (FileStat.st_mode)) {
+    if (FileStat.st_size == 0) {
+      ::close (Fd);
+      Opened = true;
+      return true;
+    }
+    if (Decompress && (Command = decompressCommand (Fd)) != NULL) {
+      ::close (Fd);
+      return openDecompressed (Filename, Command);
+    }
+    void *Map = mmap (0, FileStat.st_size, PROT_READ, MAP_PRIVATE, Fd, 0);
+    if (Map != MAP_FAILED) {
+      madvise (Map, FileStat.st_size, MADV_SEQUENTIAL);
+      ::close (Fd);
+      Data = (const char *)Map;
+      Size = FileStat.st_size;
+      Opened = true;
+      Mapped = true;
+      return true;
+    }
+  }
+
+  // Otherwise, read the file into a buffer in large blocks until EOF.
+  char *Buffer;
+  size_t Used;
+  bool Read = readBlocks (Fd, &Buffer, &Used);
+  ::close (Fd);
+  if (!Read) return false;
+  keepBuffer (Buffer, Used);
+  return true;
+}
+
+
+//------------------------------------------------------------------------------
+// openDecompressed (string, const char *) : Runs the decompression command at
+// arg2 on the file at arg1, and reads its output into a heap buffer in large
+// blocks. Returns false if the command cannot be run, or does not succeed.
+//
+bool MappedFile::openDecompressed (string Filename, const char *Command) {
+  string CommandLine = string (Command) + " -- " + shellQuote (Filename);
+  FILE *Pipe = popen (CommandLine.c_str (), "r");
+  if (!Pipe) return false;
+
+  char *Buffer;
+  size_t Used;
+  bool Read = readBlocks (fileno (Pipe), &Buffer, &Used);
+  int Status = pclose (Pipe);
+  if (Read && (Status == -1 || !WIFEXITED (Status) || WEXITSTATUS (Status))) {
+    free (Buffer);
+    Read = false;
+  }
+  if (!Read) return false;
+  keepBuffer (Buffer, Used);
+  Compressed = true;
+  return true;
+}
+
+
+//------------------------------------------------------------------------------
+// keepBuffer (char *, size_t) : Takes ownership of the heap buffer at arg1,
+// holding arg2 bytes, as the contents of the open file. An empty buffer is
+// freed at once, leaving Data pointing at EmptyFile.
+//
+void MappedFile::keepBuffer (char *Buffer, size_t Used) {
+  if (Used == 0) {
+    free (Buffer);
+  } else {
+    Data = Buffer;
+    Size = Used;
+  }
+  Opened = true;
+}
+
+
+//------------------------------------------------------------------------------
+// close () : Releases the mapping or buffer holding the current file.
+//
+void MappedFile::close () {
+  if (Data != EmptyFile) {
+    if (Mapped) munmap ((void *)Data, Size);
+    else free ((void *)Data);
+  }
+  Data = EmptyFile; Size = 0; Opened = false; Mapped = false;
+  Compressed = false;
+}
+
+
+//------------------------------------------------------------------------------
+// nextRow (const char *, const char **) : Finds the end of the row starting at
+// arg1 and stores it in arg2. Returns the start of the next row.
+//
+const char *MappedFile::nextRow (const char *Position, const char **RowEnd) const {
+  const char *End = end ();
+  if (Position >= End) { *RowEnd = End; return End; }
+  const char *Newline = (const char *)memchr (Position, '\n', End - Position);
+  if (!Newline) { *RowEnd = End; return End; }
+  *RowEnd = Newline;
+  return Newline + 1;
+}
+
+
+//------------------------------------------------------------------------------
+// countRows (const char *) : Counts the rows from arg1 to the end of the file,
+// including a final row that has no terminating newline.
+//
+size_t MappedFile::countRows (const char *Position) const {
+  const char *End = end ();
+  size_t Rows = 0;
+  while (Position < End) {
+    const char *Newline = (const char *)memchr (Position, '\n', End - Position);
+    Rows ++;
+    if (!Newline) break;
+    Position = Newline + 1;
+  }
+  return Rows;
+}
+
+
+//------------------------------------------------------------------------------
+// StreamedFile default constructor : Creates a StreamedFile with no file open.
+//
+StreamedFile::StreamedFile () {
+  Position = File.end (); Pipe = NULL; Fd = -1; Buffer = 0;
+  Capacity = 0; Start = 0; Used = 0;
+  Opened = false; Streamed = false; Compressed = false; AtEnd = true;
+  Failed = false;
+}
+
+
+//------------------------------------------------------------------------------
+// open (string) : Opens the file at arg1 to be read one row at a time. An
+// uncompressed regular file is mapped into memory. A gzip or zstd compressed
+// file is decompressed through a pipe, and any other file is read directly, in
+// either case one block at a time. Any file already open is closed first.
+// Returns false if the file cannot be opened, or if it is compressed and the
+// decompression command fails before giving any output.
+//
+bool StreamedFile::open (string Filename) {
+  struct stat FileStat;
+  const char *Command = NULL;
+  close ();
+
+  Fd = ::open (Filename.c_str (), O_RDONLY);
+  if (Fd < 0) return false;
+  bool Regular = fstat (Fd, &FileStat) == 0 && S_ISREG (FileStat.st_mode);
+  if (Regular && FileStat.st_size > 0) Command = decompressCommand (Fd);
+
+  // Uncompressed regular files are mapped, as by MappedFile.
+  if (Regular && !Command) {
+    ::close (Fd);
+    Fd = -1;
+    if (!File.open (Filename, false)) return false;
+    Position = File.begin ();
+    Opened = true;
+    return true;
+  }
+
+  // Otherwise, read the file, or the output of its decompression command,
+  // block by block. The first block is read now, so that a file that cannot be
+  // decompressed at all is reported by open(), as it is by MappedFile.
+  if (Command) {
+    ::close (Fd);
+    Fd = -1;
+    string CommandLine = string (Command) + " -- " + shellQuote (Filename);
+    Pipe = popen (CommandLine.c_str (), "r");
+    if (!Pipe) return false;
+    Fd = fileno (Pipe);
+    Compressed = true;
+  }
+  Streamed = true;
+  AtEnd = false;
+  if (!fill () && Failed) {
+    close ();
+    return false;
+  }
+  Opened = true;
+  return true;
+}
+
+
+//------------------------------------------------------------------------------
+// close () : Closes the current file, releasing its mapping or buffer, and
+// waits for any decompression command to finish.
+//
+void StreamedFile::close () {
+  if (!AtEnd) finish ();
+  File.close ();
+  free (Buffer);
+  Position = File.end (); Buffer = 0; Capacity = 0; Start = 0; Used = 0;
+  Opened = false; Streamed = false; Compressed = false; AtEnd = true;
+  Failed = false;
+}
+
+
+//------------------------------------------------------------------------------
+// fill () : Moves the unread part of the buffer to its start, and reads the
+// next block of the file after it. The buffer is only enlarged if it holds
+// a single row that fills it completely. Returns false if nothing more could be
+// read, in which case the file is finished and Failed says why.
+//
+bool StreamedFile::fill () {
+  if (Start > 0) {
+    memmove (Buffer, Buffer + Start, Used - Start);
+    Used -= Start;
+    Start = 0;
+  }
+  if (Used == Capacity) {
+    char *NewBuffer = (char *)realloc (Buffer, Capacity + MF_READ_BLOCK_SIZE);
+    if (!NewBuffer) { Failed = true; finish (); return false; }
+    Buffer = NewBuffer;
+    Capacity += MF_READ_BLOCK_SIZE;
+  }
+  ssize_t BytesRead = read (Fd, Buffer + Used, Capacity - Used);
+  if (BytesRead > 0) { Used += BytesRead; return true; }
+  if (BytesRead < 0) Failed = true;
+  finish ();
+  return false;
+}
+
+
+//------------------------------------------------------------------------------
+// finish () : Closes the file being read, once it has been read to its end or
+// cannot be read further. If the file was being decompressed, the command's
+// exit status is checked, and Failed is set if it did not succeed.
+//
+void StreamedFile::finish () {
+  if (Pipe) {
+    int Status = pclose (Pipe);
+    if (Status == -1 || !WIFEXITED (Status) || WEXITSTATUS (Status)) {
+      Failed = true;
+    }
+  } else if (Fd >= 0) {
+    ::close (Fd);
+  }
+  Pipe = NULL; Fd = -1; AtEnd = true;
+}
+
+
+//------------------------------------------------------------------------------
+// nextRow (const char **, const char **) : Finds the next row of the file,
+// storing its first character in arg1 and its end in arg2. Returns false at
+// the end of the file.
+//
+bool StreamedFile::nextRow (const char **Row, const char **RowEnd) {
+  if (!Streamed) {
+    if (Position >= File.end ()) return false;
+    *Row = Position;
+    Position = File.nextRow (Position, RowEnd);
+    return true;
+  }
+
+  // Search the unread part of the buffer for a newline, reading more of the
+  // file until one is found. Only the bytes added by each read are searched.
+  size_t Searched = 0;
+  for (;;) {
+    const char *Newline = 0;
+    if (Start + Searched < Used) {
+      Newline = (const char *)memchr (Buffer + Start + Searched, '\n', 
+        Used - Start - Searched);
+    }
+    if (Newline) {
+      *Row = Buffer + Start;
+      *RowEnd = Newline;
+      Start = Newline + 1 - Buffer;
+      return true;
+    }
+    Searched = Used - Start;
+    if (AtEnd || !fill ()) break;
+  }
+
+  // The last row of the file has no terminating newline. If the file could not
+  // be read to its end, this is only part of a row, so is discarded.
+  if (Start == Used || Failed) return false;
+  *Row = Buffer + Start;
+  *RowEnd = Buffer + Used;
+  Start = Used;
+  return true;
+}
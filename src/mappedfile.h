@@ -0,0 +1,159 @@
+// Xgtools
+// Copyright (C) M. P. Ruffoni 2011-2015
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// MappedFile class (mappedfile.h)
+//==============================================================================
+// Gives read-only access to the entire contents of a file as a single block of
+// memory. Wherever possible the file is mapped into memory with mmap(), so that
+// its contents can be walked in place without being copied into a std::string
+// one row at a time. If the file cannot be mapped (for example, if it is a pipe
+// rather than a regular file), it is instead read into a heap buffer in large
+// blocks, so callers never need to distinguish between the two cases.
+//
+// Compressed files are recognised by their leading bytes. A file compressed
+// with gzip or zstd is decompressed by running 'gzip -dc' or 'zstd -dc' on it,
+// and the decompressed data are read from the pipe into the heap buffer in
+// large blocks, without being written to disk. The contents are then exactly
+// those of the uncompressed file. Pass false as the second argument to open()
+// to give the raw, compressed contents instead. Note that the whole of the
+// decompressed file is then held in memory at once, so a compressed list needs
+// as much memory as its uncompressed size, where an uncompressed one is only
+// mapped. This is no worse than the cost of the lines read from it by any code
+// that keeps every line, but a caller that only needs one row at a time should
+// use StreamedFile instead.
+//
+// The interface loosely follows that of std::ifstream. Open a file by passing
+// its name to the constructor or to open(), and check that this succeeded with
+// isOpen(). The file contents then lie in the range [begin(), end()).
+//
+// nextRow() is provided to split the contents into rows, as std::getline would.
+// Each row is returned as a pointer to its first character and a pointer to
+// its newline (or to end() for a final, unterminated row). The newline itself
+// is never included in the row.
+//
+// StreamedFile gives the same rows one at a time, for callers that never need
+// more than the current row. An uncompressed regular file is mapped by a
+// MappedFile as above. Anything else, i.e. a compressed file or a pipe, is read
+// in large blocks into a buffer that is reused once each block has been used,
+// so it is held in a fixed amount of memory, whatever its length:
+//
+//   StreamedFile List;
+//   const char *Row, *RowEnd;
+//   if (List.open (Filename)) {
+//     while (List.nextRow (&Row, &RowEnd)) { ... }
+//     if (List.failed ()) { ... }
+//   }
+//
+// Each row is only valid until the next call to nextRow(). Because the file is
+// read as it is used, an error partway through, such as a truncated compressed
+// file, is only found when it is reached. nextRow() then returns false, as at
+// the end of the file, and failed() returns true.
+//
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <string>
+#include <cstddef>
+#include <cstdio>
+
+// The number of leading bytes examined to detect a compressed file
+#define MF_MAGIC_LENGTH 4
+
+using namespace::std;
+
+class MappedFile {
+  public:
+    MappedFile ();
+    MappedFile (string Filename);
+    ~MappedFile () { close (); }
+
+    bool open (string Filename, bool Decompress = true);
+    void close ();
+    bool isOpen () { return Opened; }
+    bool isCompressed () { return Compressed; }
+
+    // GET functions for the file contents.
+    const char *begin () const { return Data; }
+    const char *end () const { return Data + Size; }
+    size_t size () const { return Size; }
+
+    // Returns the row starting at Position, setting RowEnd to the row's
+    // terminating newline. The return value is the start of the following row.
+    // If Position is already at end(), RowEnd is set to end() and end() is
+    // returned.
+    const char *nextRow (const char *Position, const char **RowEnd) const;
+
+    // Returns the number of rows in the range [Position, end()).
+    size_t countRows (const char *Position) const;
+
+  private:
+    const char *Data;
+    size_t Size;
+    bool Opened;
+    bool Mapped;
+    bool Compressed;
+
+    // Helpers for open(). See mappedfile.cpp.
+    bool openDecompressed (string Filename, const char *Command);
+    void keepBuffer (char *Buffer, size_t Used);
+
+    // A MappedFile owns its mapping, so must not be copied.
+    MappedFile (const MappedFile &);
+    void operator= (const MappedFile &);
+};
+
+class StreamedFile {
+  public:
+    StreamedFile ();
+    ~StreamedFile () { close (); }
+
+    bool open (string Filename);
+    void close ();
+    bool isOpen () { return Opened; }
+    bool isCompressed () { return Compressed; }
+
+    // Returns true if the file could not be read to its end.
+    bool failed () const { return Failed; }
+
+    // Sets arg1 to the first character of the next row, and arg2 to its
+    // terminating newline (or to the end of a final, unterminated row).
+    // Returns false, leaving both unchanged, at the end of the file.
+    bool nextRow (const char **Row, const char **RowEnd);
+
+  private:
+    MappedFile File;
+    const char *Position;
+    FILE *Pipe;
+    int Fd;
+    char *Buffer;
+    size_t Capacity, Start, Used;
+    bool Opened;
+    bool Streamed;
+    bool Compressed;
+    bool AtEnd;
+    bool Failed;
+
+    // Helpers for open() and nextRow(). See mappedfile.cpp.
+    bool fill ();
+    void finish ();
+
+    // A StreamedFile owns its file, so must not be copied.
+    StreamedFile (const StreamedFile &);
+    void operator= (const StreamedFile &);
+};
+
+#endif // MAPPED_FILE_H
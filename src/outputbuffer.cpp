@@ -0,0 +1,106 @@
+// Xgtools
+// Copyright (C) M. P. Ruffoni 2011-2015
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// OutputBuffer class (outputbuffer.cpp)
+//==============================================================================
+
+#include "outputbuffer.h"
+#include <cstdio>
+#include <cstdarg>
+#include <cstring>
+
+//------------------------------------------------------------------------------
+// String constructor : Creates an empty buffer of arg1 bytes that is not
+// written to any stream, but grows as needed to hold all the text printed.
+//
+OutputBuffer::OutputBuffer (size_t NewSize) {
+  Output = 0;
+  Size = NewSize > 0 ? NewSize : 1;
+  Data = new char [Size];
+  Used = 0;
+}
+
+
+//------------------------------------------------------------------------------
+// Stream constructor : Creates an empty buffer of arg2 bytes, the contents of
+// which will be written to the stream at arg1.
+//
+OutputBuffer::OutputBuffer (ostream &NewOutput, size_t NewSize) {
+  Output = &NewOutput;
+  Size = NewSize > 0 ? NewSize : 1;
+  Data = new char [Size];
+  Used = 0;
+}
+
+
+//------------------------------------------------------------------------------
+// print (const char *, ...) : Formats the arguments following arg1 according to
+// the printf() format string at arg1 and appends the result to the buffer. If
+// the text does not fit in the space remaining, the buffer is flushed (or
+// enlarged, if there is no stream) and the text formatted again. Returns false
+// if the buffer had to be flushed and the stream could not be written to.
+//
+bool OutputBuffer::print (const char *Format, ...) {
+  va_list Args;
+  int Length;
+
+  va_start (Args, Format);
+  Length = vsnprintf (Data + Used, Size - Used, Format, Args);
+  va_end (Args);
+  if (Length < 0) return false;
+  if ((size_t)Length < Size - Used) { Used += Length; return true; }
+
+  // The text did not fit. Make room for it and try again.
+  if (Output) {
+    if (!flush ()) return false;
+  }
+  if ((size_t)Length >= Size - Used) {
+    resize (Used + Length + 1 > 2 * Size ? Used + Length + 1 : 2 * Size);
+  }
+  va_start (Args, Format);
+  vsnprintf (Data + Used, Size - Used, Format, Args);
+  va_end (Args);
+  Used += Length;
+  return true;
+}
+
+
+//------------------------------------------------------------------------------
+// flush () : Writes the buffer contents to the output stream and empties the
+// buffer. Returns false if the stream could not be written to. When there is no
+// stream, the buffer is simply emptied.
+//
+bool OutputBuffer::flush () {
+  if (Output && Used > 0) {
+    Output -> write (Data, Used);
+  }
+  Used = 0;
+  return Output ? !Output -> fail () : true;
+}
+
+
+//------------------------------------------------------------------------------
+// resize (size_t) : Enlarges the buffer to arg1 bytes, keeping its contents.
+//
+void OutputBuffer::resize (size_t NewSize) {
+  if (NewSize <= Size) return;
+  char *NewData = new char [NewSize];
+  memcpy (NewData, Data, Used);
+  delete [] Data;
+  Data = NewData;
+  Size = NewSize;
+}
@@ -0,0 +1,83 @@
+// Xgtools
+// Copyright (C) M. P. Ruffoni 2011-2015
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// OutputBuffer class (outputbuffer.h)
+//==============================================================================
+// Collects formatted text in a single, reusable block of memory, and writes it
+// to an output stream one block at a time. This is used to write line lists,
+// where formatting each row with an ostringstream and sending it to the stream
+// with endl would otherwise allocate memory and flush the stream for every row.
+//
+// Text is added with print(), which takes a printf() format string. The
+// printf() conversions give exactly the same output as the equivalent iostream
+// width, precision and fixed/scientific manipulators, so formats can be
+// converted from one to the other without changing the output. Whenever the
+// buffer is full, its contents are written to the stream and the buffer is
+// reused. A single row larger than the whole buffer is handled by growing the
+// buffer to fit it.
+//
+// If no stream is given to the constructor, the buffer is never written out,
+// and instead grows to hold all the text added to it. This text may then be
+// retrieved with str().
+//
+// print() and flush() return false if the stream could not be written to. The
+// buffer is NOT flushed by the destructor, so always call flush() once all the
+// text has been added.
+//
+#ifndef OUTPUT_BUFFER_H
+#define OUTPUT_BUFFER_H
+
+#include <iostream>
+#include <string>
+
+// The default size of the buffer when writing to a stream
+#define OB_DEFAULT_SIZE 1048576 /* bytes */
+
+using namespace::std;
+
+class OutputBuffer {
+  public:
+    OutputBuffer (size_t Size = 256);
+    OutputBuffer (ostream &Output, size_t Size = OB_DEFAULT_SIZE);
+    ~OutputBuffer () { delete [] Data; }
+
+    // Appends text to the buffer in the format given at arg1, exactly as
+    // printf() would.
+    bool print (const char *Format, ...);
+
+    // Writes the contents of the buffer to the output stream, if there is one,
+    // and empties the buffer.
+    bool flush ();
+
+    // Returns the contents of the buffer as a string.
+    string str () const { return string (Data, Used); }
+
+  private:
+    ostream *Output;
+    char *Data;
+    size_t Size;
+    size_t Used;
+
+    // Enlarges the buffer to hold at least arg1 bytes.
+    void resize (size_t NewSize);
+
+    // An OutputBuffer owns its memory, so must not be copied.
+    OutputBuffer (const OutputBuffer &);
+    void operator= (const OutputBuffer &);
+};
+
+#endif // OUTPUT_BUFFER_H
@@ -0,0 +1,122 @@
+// Xgtools
+// Copyright (C) M. P. Ruffoni 2011-2015
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// parallel.cpp
+//==============================================================================
+
+#include "parallel.h"
+#include <vector>
+#include <cstdlib>
+#include <pthread.h>
+#include <unistd.h>
+
+using namespace::std;
+
+// The state shared between all the workers started by a call to runParallel().
+// ThreadShare is the number of threads each worker may use for nested calls.
+typedef struct td_WorkerPool {
+  pthread_mutex_t Lock;
+  unsigned int NextTask;
+  unsigned int NumTasks;
+  unsigned int ThreadShare;
+  ParallelTask Task;
+  void *Data;
+} WorkerPool;
+
+// The number of threads that the current thread may use, or zero if it is not
+// running a task, in which case numWorkerThreads() gives the full number.
+static __thread unsigned int ThreadBudget = 0;
+
+
+//------------------------------------------------------------------------------
+// runWorker (void *) : The main loop of each worker thread. Repeatedly takes
+// the next unclaimed task from the WorkerPool at arg1 and runs it, until none
+// remain. The thread's budget is set to its share of the pool while it does so,
+// and then restored, as the calling thread of runParallel() is also a worker.
+//
+static void *runWorker (void *PoolPtr) {
+  WorkerPool *Pool = (WorkerPool *) PoolPtr;
+  unsigned int TaskNum;
+  unsigned int OldBudget = ThreadBudget;
+  ThreadBudget = Pool -> ThreadShare;
+  while (true) {
+    pthread_mutex_lock (&Pool -> Lock);
+    TaskNum = Pool -> NextTask ++;
+    pthread_mutex_unlock (&Pool -> Lock);
+    if (TaskNum >= Pool -> NumTasks) break;
+    Pool -> Task (TaskNum, Pool -> Data);
+  }
+  ThreadBudget = OldBudget;
+  return 0;
+}
+
+
+//------------------------------------------------------------------------------
+// numWorkerThreads () : Returns the default number of worker threads, which
+// within a task is the budget of the thread running it.
+//
+unsigned int numWorkerThreads () {
+  if (ThreadBudget) return ThreadBudget;
+  const char *Override = getenv ("XGTOOLS_THREADS");
+  if (Override && atoi (Override) > 0) return atoi (Override);
+  long Processors = sysconf (_SC_NPROCESSORS_ONLN);
+  return Processors > 0 ? (unsigned int) Processors : 1;
+}
+
+
+//------------------------------------------------------------------------------
+// runParallel (unsigned int, ParallelTask, void *, unsigned int) : Runs tasks
+// 0 to NumTasks - 1 on a pool of NumThreads worker threads, including the
+// calling thread. If a thread cannot be created, its share of the tasks is
+// simply taken on by the remaining workers. NumThreads is limited to the
+// budget of the calling thread, which is divided between the workers.
+//
+void runParallel (unsigned int NumTasks, ParallelTask Task, void *Data,
+  unsigned int NumThreads) {
+  unsigned int Budget = numWorkerThreads ();
+  if (NumThreads == 0 || NumThreads > Budget) NumThreads = Budget;
+  if (NumThreads > NumTasks) NumThreads = NumTasks;
+
+  WorkerPool Pool;
+  pthread_mutex_init (&Pool.Lock, 0);
+  Pool.NextTask = 0;
+  Pool.NumTasks = NumTasks;
+  Pool.ThreadShare = NumThreads > 1 ? Budget / NumThreads : Budget;
+  Pool.Task = Task;
+  Pool.Data = Data;
+
+  // There is no need to start any threads for a single worker, which keeps the
+  // whole budget for any nested calls.
+  if (NumThreads <= 1) {
+    runWorker (&Pool);
+    pthread_mutex_destroy (&Pool.Lock);
+    return;
+  }
+
+  vector <pthread_t> Threads;
+  for (unsigned int i = 1; i < NumThreads; i ++) {
+    pthread_t Thread;
+    if (pthread_create (&Thread, 0, runWorker, &Pool) == 0) {
+      Threads.push_back (Thread);
+    }
+  }
+  runWorker (&Pool);
+  for (unsigned int i = 0; i < Threads.size (); i ++) {
+    pthread_join (Threads[i], 0);
+  }
+  pthread_mutex_destroy (&Pool.Lock);
+}
@@ -0,0 +1,56 @@
+// Xgtools
+// Copyright (C) M. P. Ruffoni 2011-2015
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// parallel.h
+//==============================================================================
+// A minimal worker pool built on POSIX threads. runParallel() calls a task
+// function once for each task number in [0, NumTasks), sharing the tasks
+// between a number of worker threads. The calling thread acts as one of the
+// workers, and runParallel() only returns once every task has completed.
+//
+// Tasks are handed out in ascending order, but may complete in any order, so
+// each task should write its results to its own slot in the shared Data. Task
+// functions must not throw. Any error should instead be recorded in Data and
+// examined once runParallel() returns.
+//
+// A task may itself call runParallel(), as when each of several line lists
+// being calibrated in parallel is parsed in parallel too. So that the nested
+// pools do not multiply the number of threads, each thread running a task is
+// given an equal share of the threads of the pool that runs it. A nested call
+// to runParallel() starts no more threads than this share, and runs its tasks
+// inline if the share is a single thread. The tasks of a pool that uses every
+// available thread therefore never start any more.
+//
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+// The signature of a task function. arg1 is the task number, arg2 is the Data
+// pointer given to runParallel().
+typedef void (*ParallelTask) (unsigned int TaskNum, void *Data);
+
+// Returns the number of worker threads to use by default. This is the number
+// of online processors, unless overridden by the XGTOOLS_THREADS environment
+// variable. Within a task, it is instead the share of the threads given to
+// the thread running the task.
+unsigned int numWorkerThreads ();
+
+// Runs NumTasks tasks on up to NumThreads threads. If NumThreads is zero, or
+// greater than the value returned by numWorkerThreads(), that value is used.
+void runParallel (unsigned int NumTasks, ParallelTask Task, void *Data,
+  unsigned int NumThreads = 0);
+
+#endif // PARALLEL_H
@@ -0,0 +1,185 @@
+// Xgtools
+// Copyright (C) M. P. Ruffoni 2011-2015
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// recordlayout.h
+//==============================================================================
+// Describes the layout of each type of text record that Xgtools reads or
+// writes: XGremlin 'writelines' rows, XGremlin 'syn' rows, and the records of
+// a Kurucz gf*.lines list. Each layout is written once, here, and both the code
+// that parses a record and the code that formats it are generated from it. The
+// two can therefore never disagree about the order, type, or format of the
+// fields in a record.
+//
+// A layout is a macro that lists the fields of a record in the order in which
+// they appear. It takes as arguments the names of several "field macros", one
+// for each kind of field, and expands to a call to the appropriate field macro
+// for every field. The field macros are supplied by the code using the layout,
+// and determine what is generated. For example,
+//
+//   WRITELINES_LAYOUT (LAYOUT_INT_FORMAT, LAYOUT_REAL_FORMAT, ...)
+//
+// expands to the complete printf() format string for a writelines row, while
+//
+//   WRITELINES_LAYOUT (LAYOUT_INT_READ, LAYOUT_REAL_READ, ...)
+//
+// expands to the statements that read each field from a RowTokenizer. All of
+// this is done by the preprocessor, so the generated code is exactly what would
+// have been written by hand: one printf() call with a constant format string,
+// or one straight run of tokenizer calls, with no table to look up at run time.
+//
+// The field macros common to several layouts are defined below. Those that are
+// specific to one class (such as how Line and XgLine store their tags) are
+// defined alongside that class.
+//
+#ifndef RECORD_LAYOUT_H
+#define RECORD_LAYOUT_H
+
+//------------------------------------------------------------------------------
+// XGremlin 'writelines' rows : Read by Line::createLine() and written by
+// Line::getLineString(), and likewise for XgLine. The field macros are
+//
+//   INT  (Column, Member, Get, Width)
+//   REAL (Column, Member, Get, Width, Precision, Notation)
+//   TAG  (Column, Member, Get, Width, Read)
+//   TEXT (Column, Member, Spec, Read)
+//   GAP  (Text)
+//
+// Column is the name thrown if the field cannot be read, Member is the class
+// variable the field is read into, and Get the GET function whose value is
+// written (and which applies any wavenumber correction). Numeric fields are
+// written with printf()'s "%<Width>.<Precision><Notation>" conversion, and are
+// read as whitespace-separated values, as XGremlin allows. TAG and TEXT fields
+// may contain spaces, so are read as fixed-width fields of Read characters,
+// starting from the field's first non-space character. TEXT fields are written
+// with the printf() conversion Spec. GAP gives the literal text written
+// between two fields, which the parser treats as whitespace.
+//
+#define WRITELINES_LAYOUT(INT, REAL, TAG, TEXT, GAP)                           \
+  INT  (index,       Index,          line,          6)                         \
+  GAP  ("  ")                                                                  \
+  REAL (wavenumber,  Wavenumber,     wavenumber,   12, 6, f)                   \
+  REAL (peak height, Peak,           peak,         10, 3, e)                   \
+  REAL (width,       Width,          width,         9, 2, f)                   \
+  REAL (dmp,         Dmp,            dmp,           9, 4, f)                   \
+  REAL (eqwidth,     EqWidth,        eqwidth,      11, 4, e)                   \
+  INT  (itn,         Itn,            itn,           6)                         \
+  INT  (h,           H,              h,             4)                         \
+  TAG  (tags,        Tags,           tags,          5, LINE_TAG_STRING_LEN - 1)\
+  REAL (epstot,      EpsTot,         epstot,       11, 4, e)                   \
+  REAL (epsevn,      EpsEvn,         epsevn,       11, 4, e)                   \
+  REAL (epsodd,      EpsOdd,         epsodd,       11, 4, e)                   \
+  REAL (epsran,      EpsRan,         epsran,       11, 4, e)                   \
+  GAP  (" ")                                                                   \
+  TEXT (id,          Identification, "%-30.30s",   LINE_ID_STRING_LEN - 1)     \
+  REAL (wavelength,  Wavelength,     wavelength,   11, 6, f)
+
+//------------------------------------------------------------------------------
+// XGremlin 'syn' rows : Written by Line::getLineSynString(), and likewise for
+// XgLine. These are only ever written by Xgtools, so have no parser. The field
+// macros are as for WRITELINES_LAYOUT. The identification is not truncated.
+//
+#define SYN_LAYOUT(REAL, TEXT, GAP)                                            \
+  TEXT (id,          Identification, "%-15s",      0)                          \
+  GAP  ("  ")                                                                  \
+  REAL (wavenumber,  Wavenumber,     wavenumber,   12, 5, f)                   \
+  REAL (peak height, Peak,           peak,         10, 4, f)                   \
+  REAL (width,       Width,          width,         9, 2, f)                   \
+  REAL (dmp,         Dmp,            dmp,           8, 4, f)
+
+//------------------------------------------------------------------------------
+// Kurucz gf*.lines records : Read by KzLine::readLine() and written by
+// KzLine::lineString(). Unlike writelines rows, these are strictly fixed-width,
+// so every field, including any GAP, is read from its own columns. The
+// position of a field is the sum of the widths of the fields before it, so
+// there is no separate offset to keep in step. The field macros are
+//
+//   INT  (Member, Width, Required)
+//   REAL (Member, Width, Precision, Required)
+//   CHAR (Member)
+//   TEXT (Member, Width)
+//   GAP  (Text)
+//
+// Member is the KzLine class variable holding the field. Numeric fields are
+// written right-aligned in Width characters, REAL fields with Precision
+// decimal places. If a Required field is blank or cannot be read, the record
+// is rejected. Other numeric fields are set to zero instead. CHAR fields are a
+// single character, and TEXT fields are right-aligned strings of Width
+// characters. The whole record must be KZ_RECORD_LENGTH characters long.
+//
+#define KURUCZ_LAYOUT(INT, REAL, CHAR, TEXT, GAP)                              \
+  REAL (Lambda,           11, 4, true)                                         \
+  REAL (Loggf,             7, 3, true)                                         \
+  REAL (Code,              6, 2, true)                                         \
+  REAL (ELower,           12, 3, true)                                         \
+  REAL (JLower,            5, 1, true)                                         \
+  GAP  (" ")                                                                   \
+  TEXT (ConfigLower,      10)                                                  \
+  REAL (EUpper,           12, 3, true)                                         \
+  REAL (JUpper,            5, 1, true)                                         \
+  GAP  (" ")                                                                   \
+  TEXT (ConfigUpper,      10)                                                  \
+  REAL (GammaRad,          6, 2, true)                                         \
+  REAL (GammaStark,        6, 2, true)                                         \
+  REAL (GammaWaals,        6, 2, true)                                         \
+  TEXT (Ref,               4)                                                  \
+  INT  (NlteLower,         2, true)                                            \
+  INT  (NlteUpper,         2, true)                                            \
+  INT  (Isotope,           3, true)                                            \
+  REAL (HfStrength,        6, 3, true)                                         \
+  INT  (Isotope2,          3, true)                                            \
+  REAL (IsotopeAbundance,  6, 3, true)                                         \
+  INT  (HfShiftLower,      5, false)                                           \
+  INT  (HfShiftUpper,      5, false)                                           \
+  GAP  (" ")                                                                   \
+  INT  (HfFLower,          1, false)                                           \
+  CHAR (HfNoteLower)                                                           \
+  GAP  (" ")                                                                   \
+  INT  (HfFUpper,          1, false)                                           \
+  CHAR (HfNoteUpper)                                                           \
+  INT  (StrengthClass,     1, false)                                           \
+  TEXT (TagCode,           3)                                                  \
+  INT  (LandeGLower,       5, true)                                            \
+  INT  (LandeGUpper,       5, true)                                            \
+  INT  (IsotopeShift,      6, false)
+
+//------------------------------------------------------------------------------
+// Common field macros. The _FORMAT macros expand to the printf() conversion for
+// each field, so that a layout expands to a complete format string. The _ARG
+// macros expand to ", <value>" for each field, so that a layout expands to the
+// argument list for that format. The _READ macros expand to the statement that
+// reads each writelines field from the RowTokenizer named Row. LAYOUT_NONE
+// expands to nothing, for fields that a particular use of a layout skips.
+//
+#define LAYOUT_INT_FORMAT(Column, Member, Get, Width) "%" #Width "d"
+#define LAYOUT_REAL_FORMAT(Column, Member, Get, Width, Precision, Notation)    \
+  "%" #Width "." #Precision #Notation
+#define LAYOUT_TEXT_FORMAT(Column, Member, Spec, Read) Spec
+#define LAYOUT_GAP_FORMAT(Text) Text
+
+#define LAYOUT_INT_ARG(Column, Member, Get, Width) , Get ()
+#define LAYOUT_REAL_ARG(Column, Member, Get, Width, Precision, Notation)       \
+  , Get ()
+#define LAYOUT_TEXT_ARG(Column, Member, Spec, Read) , Member.c_str ()
+
+#define LAYOUT_INT_READ(Column, Member, Get, Width)                            \
+  Member = Row.getInt (#Column);
+#define LAYOUT_REAL_READ(Column, Member, Get, Width, Precision, Notation)      \
+  Member = Row.getDouble (#Column);
+
+#define LAYOUT_NONE(Text)
+
+#endif // RECORD_LAYOUT_H
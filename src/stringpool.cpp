@@ -0,0 +1,221 @@
+// Xgtools
+// Copyright (C) M. P. Ruffoni 2011-2015
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// StringPool class (stringpool.cpp)
+//==============================================================================
+
+#include "stringpool.h"
+#include <iostream>
+
+// The offset basis and prime of the 32-bit FNV-1a hash
+#define SP_FNV_OFFSET 2166136261U
+#define SP_FNV_PRIME 16777619U
+
+//------------------------------------------------------------------------------
+// Default constructor : Creates a pool holding only the empty string.
+//
+StringPool::StringPool () : Slots (SP_MIN_SLOTS, SP_NO_HANDLE) {
+  NumDirectories = 0;
+  NumStrings = 0;
+  StoredBytes = 0;
+  pthread_mutex_init (&Lock, NULL);
+  intern (string ());
+}
+
+
+//------------------------------------------------------------------------------
+// Destructor : Frees every block of strings, and the directories holding them.
+//
+StringPool::~StringPool () {
+  for (unsigned int i = 0; i < NumDirectories; i ++) {
+    for (unsigned int j = 0; j < SP_DIRECTORY_SIZE && Directories[i][j]; j ++) {
+      delete [] Directories[i][j];
+    }
+    delete [] Directories[i];
+  }
+  pthread_mutex_destroy (&Lock);
+}
+
+
+//------------------------------------------------------------------------------
+// intern (const string &) : Returns the handle of the string at arg1, adding it
+// to the pool if it is not already there.
+//
+StringPool::Handle StringPool::intern (const string &String) throw (Error) {
+  pthread_mutex_lock (&Lock);
+  Handle NewHandle = insert (String);
+  pthread_mutex_unlock (&Lock);
+  if (NewHandle == SP_NO_HANDLE) {
+    cout << "Error: Too many distinct strings to store. Unable to continue." 
+      << endl;
+    throw Error (SP_POOL_FULL);
+  }
+  return NewHandle;
+}
+
+
+//------------------------------------------------------------------------------
+// merge (const StringPool &, vector <Handle> *) : Interns every string in the
+// pool at arg1, in the order of their handles, under a single lock. The handle
+// in this pool of the string with handle i in arg1 is stored in element i of
+// the vector at arg2.
+//
+void StringPool::merge (const StringPool &Source, vector <Handle> *Handles)
+  throw (Error) {
+  Handles -> resize (Source.size ());
+  pthread_mutex_lock (&Lock);
+  for (unsigned int i = 0; i < Source.size (); i ++) {
+    (*Handles)[i] = insert (Source.get (i));
+    if ((*Handles)[i] == SP_NO_HANDLE) {
+      pthread_mutex_unlock (&Lock);
+      cout << "Error: Too many distinct strings to store. Unable to continue." 
+        << endl;
+      throw Error (SP_POOL_FULL);
+    }
+  }
+  pthread_mutex_unlock (&Lock);
+}
+
+
+//------------------------------------------------------------------------------
+// clear () : Empties the pool, leaving only the empty string. Rather than
+// resetting the whole lookup table, the slot of each string is found from its
+// hash and emptied. The search for a slot cannot stop at an empty slot, as
+// these are being created as it runs, so it looks for the handle itself, which
+// always lies at or after the string's hashed slot.
+//
+void StringPool::clear () {
+  pthread_mutex_lock (&Lock);
+  size_t Mask = Slots.size () - 1;
+  for (Handle i = 0; i < NumStrings; i ++) {
+    size_t Slot = hash (get (i)) & Mask;
+    while (Slots[Slot] != i) Slot = (Slot + 1) & Mask;
+    Slots[Slot] = SP_NO_HANDLE;
+  }
+  NumStrings = 0;
+  StoredBytes = 0;
+  insert (string ());
+  pthread_mutex_unlock (&Lock);
+}
+
+
+//------------------------------------------------------------------------------
+// bytes () : Returns the estimated memory used by the pool. StoredBytes counts
+// the heap buffers of the strings, while the std::string objects themselves are
+// counted here, as every allocated block is counted in full.
+//
+size_t StringPool::bytes () const {
+  size_t NumBlocks = (NumStrings + SP_BLOCK_SIZE - 1) / SP_BLOCK_SIZE;
+  return sizeof (StringPool) + StoredBytes 
+    + NumBlocks * SP_BLOCK_SIZE * sizeof (string)
+    + NumDirectories * SP_DIRECTORY_SIZE * sizeof (string*)
+    + Slots.size () * sizeof (Handle);
+}
+
+
+//------------------------------------------------------------------------------
+// stringBytes (const string &) : Returns the size of a std::string holding arg1,
+// plus its heap buffer. Short strings that fit within the std::string itself,
+// as in most implementations, have no heap buffer.
+//
+size_t StringPool::stringBytes (const string &String) {
+  static const size_t InlineCapacity = string ().capacity ();
+  if (String.capacity () <= InlineCapacity) return sizeof (string);
+  return sizeof (string) + String.capacity () + 1;
+}
+
+
+//------------------------------------------------------------------------------
+// hash (const string &) : Returns the 32-bit FNV-1a hash of arg1.
+//
+uint32_t StringPool::hash (const string &String) {
+  uint32_t Hash = SP_FNV_OFFSET;
+  for (size_t i = 0; i < String.size (); i ++) {
+    Hash = (Hash ^ (unsigned char) String[i]) * SP_FNV_PRIME;
+  }
+  return Hash;
+}
+
+
+//------------------------------------------------------------------------------
+// findSlot (const string &) : Returns the slot in the lookup table holding the
+// handle of the string at arg1 or, if it is not in the pool, the empty slot
+// into which its handle should be placed. Collisions are resolved by linear
+// probing, and the table is never full, so the search always ends.
+//
+size_t StringPool::findSlot (const string &String) const {
+  size_t Mask = Slots.size () - 1;
+  size_t Slot = hash (String) & Mask;
+  while (Slots[Slot] != SP_NO_HANDLE && get (Slots[Slot]) != String) {
+    Slot = (Slot + 1) & Mask;
+  }
+  return Slot;
+}
+
+
+//------------------------------------------------------------------------------
+// growSlots () : Doubles the size of the lookup table, and re-inserts every
+// handle into the new table.
+//
+void StringPool::growSlots () {
+  vector <Handle> OldSlots (Slots.size () * 2, SP_NO_HANDLE);
+  Slots.swap (OldSlots);
+  size_t Mask = Slots.size () - 1;
+  for (size_t i = 0; i < OldSlots.size (); i ++) {
+    if (OldSlots[i] == SP_NO_HANDLE) continue;
+    size_t Slot = hash (get (OldSlots[i])) & Mask;
+    while (Slots[Slot] != SP_NO_HANDLE) Slot = (Slot + 1) & Mask;
+    Slots[Slot] = OldSlots[i];
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// insert (const string &) : Returns the handle of the string at arg1. If the
+// string is not yet in the pool, it is appended to the last block, and a new
+// block, and if need be a new directory, allocated if that is full. Its handle
+// is then added to the lookup table, which is first enlarged if necessary.
+// Returns SP_NO_HANDLE if every handle has already been used. The caller must
+// hold the mutex.
+//
+StringPool::Handle StringPool::insert (const string &String) {
+  size_t Slot = findSlot (String);
+  if (Slots[Slot] != SP_NO_HANDLE) return Slots[Slot];
+  if (NumStrings == SP_NO_HANDLE) return SP_NO_HANDLE;
+  Handle NewHandle = NumStrings;
+  unsigned int Directory = NewHandle >> (SP_BLOCK_BITS + SP_DIRECTORY_BITS);
+  unsigned int Block = (NewHandle >> SP_BLOCK_BITS) & (SP_DIRECTORY_SIZE - 1);
+  if (Directory == NumDirectories) {
+    Directories[Directory] = new string* [SP_DIRECTORY_SIZE];
+    for (unsigned int i = 0; i < SP_DIRECTORY_SIZE; i ++) {
+      Directories[Directory][i] = 0;
+    }
+    NumDirectories ++;
+  }
+  if (!Directories[Directory][Block]) {
+    Directories[Directory][Block] = new string [SP_BLOCK_SIZE];
+  }
+  Directories[Directory][Block][NewHandle & (SP_BLOCK_SIZE - 1)] = String;
+  NumStrings ++;
+  StoredBytes += stringBytes (String) - sizeof (string);
+  if (2 * NumStrings > Slots.size ()) {
+    growSlots ();
+    Slot = findSlot (String);
+  }
+  Slots[Slot] = NewHandle;
+  return NewHandle;
+}
@@ -0,0 +1,148 @@
+// Xgtools
+// Copyright (C) M. P. Ruffoni 2011-2015
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// StringPool class (stringpool.h)
+//==============================================================================
+// Stores each distinct string given to it once, and refers to it thereafter by
+// a 32-bit handle. Objects that would otherwise each own a copy of the same
+// string, such as the lines of a list that all share one source filename, can
+// instead hold a handle to a single copy in the pool. This saves both the
+// memory and the heap allocation of every duplicate.
+//
+// intern() returns the handle of a string, adding it to the pool if it is not
+// already there, and get() returns the string for a handle. The empty string is
+// always present, with the handle SP_EMPTY, so a default handle needs no call
+// to intern(). Strings are never removed from a pool individually, so a handle
+// remains valid for the lifetime of the pool, or until clear() is called. This
+// empties the pool in one go, in time proportional to the number of strings it
+// held, so that a pool holding only the strings of a few objects at a time,
+// such as the line most recently read from a list, can be reused cheaply.
+//
+// A pool may be shared between threads. intern() is serialised with a mutex.
+// get() takes no lock, as the strings are held in fixed blocks that never move,
+// and a handle can only be obtained after its string has been stored. Threads
+// that would intern many strings can instead each intern them into a private
+// pool, and then add them to the shared pool with merge(), which takes the
+// mutex only once.
+//
+// The blocks are found through a two-level table. The top level is fixed, and
+// each of its entries points to a directory of blocks, which is only allocated
+// once the first block in it is needed. The table therefore grows with the
+// pool, without ever moving, until every 32-bit handle has been used.
+//
+// intern() finds existing strings through an open-addressed hash table of
+// handles, which hashes and compares each entry through get(). Each string is
+// therefore held only once, in its block, rather than again as a lookup key.
+//
+// For load statistics, bytes() estimates the memory used by the pool, and
+// stringBytes() that used by a single std::string. Together these give the
+// memory saved by pooling a set of strings.
+//
+#ifndef STRING_POOL_H
+#define STRING_POOL_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <stdint.h>
+#include <pthread.h>
+#include "ErrDefs.h"
+
+// The handle of the empty string in every pool
+#define SP_EMPTY 0
+
+// A value that is never used as a handle. It marks an empty slot in the lookup
+// table, leaving 2^32 - 1 handles for the strings themselves.
+#define SP_NO_HANDLE 0xFFFFFFFF
+
+// The strings are stored in blocks of SP_BLOCK_SIZE, and the blocks in
+// directories of SP_DIRECTORY_SIZE. A handle gives the directory, the block
+// within it, and the string within that, so there are enough directories,
+// SP_NUM_DIRECTORIES, to hold a string for every handle.
+#define SP_BLOCK_BITS 12
+#define SP_BLOCK_SIZE (1 << SP_BLOCK_BITS)
+#define SP_DIRECTORY_BITS 10
+#define SP_DIRECTORY_SIZE (1 << SP_DIRECTORY_BITS)
+#define SP_NUM_DIRECTORIES (1 << (32 - SP_BLOCK_BITS - SP_DIRECTORY_BITS))
+
+// The initial number of slots in the lookup table. The table is kept at most
+// half full, and doubled in size whenever it would be filled beyond that.
+#define SP_MIN_SLOTS 1024
+
+using namespace::std;
+
+class StringPool {
+  public:
+    typedef uint32_t Handle;
+
+    StringPool ();
+    ~StringPool ();
+
+    // Returns the handle of the string at arg1, adding it to the pool if
+    // necessary. Throws SP_POOL_FULL if every handle has already been used.
+    Handle intern (const string &String) throw (Error);
+
+    // Interns every string in the pool at arg1, and stores their handles in
+    // this pool in the vector at arg2, indexed by their handles in arg1.
+    // Throws SP_POOL_FULL if every handle has already been used.
+    void merge (const StringPool &Source, vector <Handle> *Handles)
+      throw (Error);
+
+    // Removes every string from the pool but the empty string, invalidating
+    // every other handle. The memory allocated for the strings is kept for
+    // reuse, so a pool that is cleared often never grows beyond its fullest.
+    void clear ();
+
+    // Returns the string with the handle at arg1.
+    const string &get (Handle StringHandle) const
+      { return Directories [StringHandle >> (SP_BLOCK_BITS + SP_DIRECTORY_BITS)]
+        [(StringHandle >> SP_BLOCK_BITS) & (SP_DIRECTORY_SIZE - 1)]
+        [StringHandle & (SP_BLOCK_SIZE - 1)]; }
+
+    // Pool statistics. size() is the number of distinct strings in the pool,
+    // and bytes() the estimated memory used by the pool, including its lookup
+    // table, its directories, and any unused space in its last block.
+    unsigned int size () const { return NumStrings; }
+    size_t bytes () const;
+
+    // Returns the memory used by a std::string holding the string at arg1,
+    // including its heap buffer, if it has one.
+    static size_t stringBytes (const string &String);
+
+  private:
+    string **Directories [SP_NUM_DIRECTORIES];
+    unsigned int NumDirectories;
+    unsigned int NumStrings;
+    vector <Handle> Slots;
+    pthread_mutex_t Lock;
+
+    // The memory used by the strings, beyond the std::string objects themselves
+    size_t StoredBytes;
+
+    // Private methods for the lookup table. insert() does the work of intern()
+    // with the mutex already held, returning SP_NO_HANDLE if the pool is full.
+    Handle insert (const string &String);
+    static uint32_t hash (const string &String);
+    size_t findSlot (const string &String) const;
+    void growSlots ();
+
+    // A StringPool owns its strings, so must not be copied.
+    StringPool (const StringPool &);
+    void operator= (const StringPool &);
+};
+
+#endif // STRING_POOL_H
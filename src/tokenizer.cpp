@@ -0,0 +1,231 @@
+// Xgtools
+// Copyright (C) M. P. Ruffoni 2011-2015
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// RowTokenizer class (tokenizer.cpp)
+//==============================================================================
+
+#include "tokenizer.h"
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <climits>
+#include <cerrno>
+#include <cmath>
+#include <pthread.h>
+
+// The largest number of digits, the largest mantissa, and the largest power of
+// ten for which getDouble() can convert a field exactly with a single
+// multiplication or division. Beyond these limits, slowDouble() is used.
+#define TOK_MAX_FAST_DIGITS 19
+#define TOK_MAX_FAST_MANTISSA 9007199254740992ULL /* 2^53 */
+#define TOK_MAX_FAST_EXPONENT 22
+
+// The longest numeric field that slowDouble() will copy to the stack
+#define TOK_MAX_FIELD_LEN 64
+
+static const double PowersOfTen [TOK_MAX_FAST_EXPONENT + 1] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13,
+  1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Rows may be parsed on several threads at once (see chunkparse.h), so an
+// overload warning printed without a ParseDiagnostics is printed under a lock
+// to stop warnings interleaving.
+static pthread_mutex_t WarningLock = PTHREAD_MUTEX_INITIALIZER;
+
+
+//------------------------------------------------------------------------------
+// getInt (const char *) : Reads an integer field, as istream >> int would.
+//
+int RowTokenizer::getInt (const char *Column) throw (const char*) {
+  skipSpace ();
+  const char *p = Position;
+  bool Negative = false;
+  if (p < RowEnd && (*p == '-' || *p == '+')) { Negative = (*p == '-'); p ++; }
+  if (p == RowEnd || !isDigit (*p)) { checkOverload (Column); return 0; }
+
+  long long Value = 0;
+  while (p < RowEnd && isDigit (*p)) {
+    Value = Value * 10 + (*p - '0');
+    if (Value > (long long)INT_MAX + 1) throw Column;
+    p ++;
+  }
+  if (Negative) Value = -Value;
+  if (Value > INT_MAX || Value < INT_MIN) throw Column;
+  Position = p;
+  return (int)Value;
+}
+
+
+//------------------------------------------------------------------------------
+// getDouble (const char *) : Reads a floating point field of the form
+// [+-]digits[.digits][(e|E)[+-]digits], as istream >> double would. Fields with
+// up to TOK_MAX_FAST_DIGITS digits and a small decimal exponent are converted
+// exactly from their integer mantissa. Both the mantissa and the
+// power of ten are then exactly representable, so a single multiplication or
+// division gives the correctly rounded result, just as strtod() would.
+//
+double RowTokenizer::getDouble (const char *Column) throw (const char*) {
+  skipSpace ();
+  const char *p = Position, *Start = Position;
+  bool Negative = false;
+  if (p < RowEnd && (*p == '-' || *p == '+')) { Negative = (*p == '-'); p ++; }
+
+  // Accumulate every digit of the integer and fractional parts into Mantissa,
+  // noting how many there are. If there are too many to be held exactly, the
+  // slow path below is taken instead.
+  unsigned long long Mantissa = 0;
+  int Digits = 0, Exponent = 0;
+  const char *DigitStart = p;
+  while (p < RowEnd && isDigit (*p)) {
+    Mantissa = Mantissa * 10 + (*p ++ - '0');
+  }
+  Digits = p - DigitStart;
+  if (p < RowEnd && *p == '.') {
+    const char *FractionStart = ++ p;
+    while (p < RowEnd && isDigit (*p)) {
+      Mantissa = Mantissa * 10 + (*p ++ - '0');
+    }
+    Exponent = FractionStart - p;
+    Digits -= Exponent;
+  }
+  if (Digits == 0) { checkOverload (Column); return 0.0; }
+
+  // Exponent. This is only consumed if it contains at least one digit.
+  if (p < RowEnd && (*p == 'e' || *p == 'E')) {
+    const char *e = p + 1;
+    bool NegativeExp = false;
+    if (e < RowEnd && (*e == '-' || *e == '+')) { NegativeExp = (*e == '-'); e ++; }
+    if (e < RowEnd && isDigit (*e)) {
+      int ExpValue = 0;
+      while (e < RowEnd && isDigit (*e)) {
+        if (ExpValue < 100000) ExpValue = ExpValue * 10 + (*e - '0');
+        e ++;
+      }
+      Exponent += NegativeExp ? -ExpValue : ExpValue;
+      p = e;
+    }
+  }
+  Position = p;
+
+  double Value;
+  if (Digits <= TOK_MAX_FAST_DIGITS && Mantissa == 0) {
+    Value = 0.0;
+  } else if (Digits <= TOK_MAX_FAST_DIGITS && Mantissa <= TOK_MAX_FAST_MANTISSA
+    && Exponent >= -TOK_MAX_FAST_EXPONENT && Exponent <= TOK_MAX_FAST_EXPONENT) {
+    Value = (double)Mantissa;
+    if (Exponent < 0) Value /= PowersOfTen [-Exponent];
+    else Value *= PowersOfTen [Exponent];
+  } else {
+    if (!slowDouble (Start, p, Value)) { Position = Start; checkOverload (Column); }
+    return Value;
+  }
+  return Negative ? -Value : Value;
+}
+
+
+//------------------------------------------------------------------------------
+// getChar (const char *) : Reads a single non-whitespace character.
+//
+char RowTokenizer::getChar (const char *Column) throw (const char*) {
+  skipSpace ();
+  if (Position == RowEnd) throw Column;
+  return *Position ++;
+}
+
+
+//------------------------------------------------------------------------------
+// getFixed (string &, int, bool) : Skips any whitespace, then reads the next
+// Width characters (or up to the end of the row) into the string at arg1. The
+// second form reads them into the character array at arg1 instead. If
+// TrimRight is true, trailing spaces are removed from the field. Returns false
+// if no characters remain in the row.
+//
+bool RowTokenizer::getFixed (string &Field, int Width, bool TrimRight) {
+  skipSpace ();
+  const char *FieldEnd = Position + Width;
+  if (FieldEnd > RowEnd) FieldEnd = RowEnd;
+  const char *Start = Position;
+  Position = FieldEnd;
+  if (TrimRight) {
+    while (FieldEnd > Start && FieldEnd [-1] == ' ') FieldEnd --;
+  }
+  Field.assign (Start, FieldEnd);
+  return Position != Start;
+}
+
+bool RowTokenizer::getFixed (char *Field, int Width, bool TrimRight) {
+  skipSpace ();
+  const char *FieldEnd = Position + Width;
+  if (FieldEnd > RowEnd) FieldEnd = RowEnd;
+  const char *Start = Position;
+  Position = FieldEnd;
+  if (TrimRight) {
+    while (FieldEnd > Start && FieldEnd [-1] == ' ') FieldEnd --;
+  }
+  memcpy (Field, Start, FieldEnd - Start);
+  Field [FieldEnd - Start] = '\0';
+  return Position != Start;
+}
+
+
+//------------------------------------------------------------------------------
+// checkOverload (const char *) : Called when a numeric field could not be read.
+// If the field starts with XGremlin's overload marker, it is recorded in the
+// ParseDiagnostics, or a warning printed if there is none, and the marker
+// skipped, so that reading may continue. Otherwise, the name of the
+// column at arg1 is thrown. As with the istringstream parser this replaced,
+// which compared the whole whitespace-delimited field with XG_OVERLOAD, the
+// marker must be followed by whitespace or the end of the row.
+//
+void RowTokenizer::checkOverload (const char *Column) throw (const char*) {
+  const char *p = Position;
+  int Stars = 0;
+  while (p < RowEnd && *p == '*') { p ++; Stars ++; }
+  if (Stars != XG_OVERLOAD_LEN || (p < RowEnd && !isSpace (*p))) throw Column;
+  Position = p;
+  if (Diagnostics) {
+    Diagnostics -> overload (Column, Row);
+    return;
+  }
+  pthread_mutex_lock (&WarningLock);
+  cout << "Warning: " << XG_OVERLOAD << " has been found in the " << Column
+    << " column. A value of zero has been taken instead." << endl;
+  pthread_mutex_unlock (&WarningLock);
+}
+
+
+//------------------------------------------------------------------------------
+// slowDouble (const char *, const char *, double &) : Converts a numeric field
+// that was too long or too precise for the fast path in getDouble(), storing
+// the result at arg3. As with istream >> double, a value too large to be held
+// in a double is an error, in which case false is returned.
+//
+bool RowTokenizer::slowDouble (const char *Begin, const char *End, double &Value) {
+  errno = 0;
+  if (End - Begin < TOK_MAX_FIELD_LEN) {
+    char Field [TOK_MAX_FIELD_LEN];
+    int i = 0;
+    while (Begin < End) Field [i ++] = *Begin ++;
+    Field [i] = '\0';
+    Value = strtod (Field, 0);
+  } else {
+    string Field (Begin, End);
+    Value = strtod (Field.c_str (), 0);
+  }
+  return !(errno == ERANGE && (Value == HUGE_VAL || Value == -HUGE_VAL));
+}
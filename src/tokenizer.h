@@ -0,0 +1,92 @@
+// Xgtools
+// Copyright (C) M. P. Ruffoni 2011-2015
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// RowTokenizer class (tokenizer.h)
+//==============================================================================
+// Extracts the fields from a single row of an XGremlin 'writelines' line list.
+// This is shared by Line::createLine() and XgLine::createLine(), and replaces
+// the chained istringstream extraction they used previously. The row is read
+// in place from the character range given to the constructor, so no copy of
+// the row is ever made.
+//
+// Fields are separated by whitespace, and each GET function skips any leading
+// whitespace before reading its field, exactly as the istream >> operators do.
+// Numeric fields are converted directly from the row. Where a numeric field
+// contains XGremlin's overload marker, XG_OVERLOAD, the marker is skipped, and
+// zero is returned. The overload is recorded in the ParseDiagnostics given to
+// the constructor, along with the row number, to be reported once parsing is
+// complete. If there is no ParseDiagnostics, a warning is printed at once
+// instead. Any other malformed field causes the name of the column, passed in
+// at arg1, to be thrown as a const char*.
+//
+// The line identification and tags fields may contain spaces, so are read as
+// fixed-width fields with getFixed(). Like istream::get(), this returns false
+// if the field is empty, leaving the caller to decide whether that's an error.
+// The field may be read into either a string or a character array, which must
+// have room for Width characters and a terminating null.
+//
+#ifndef ROW_TOKENIZER_H
+#define ROW_TOKENIZER_H
+
+#include <string>
+#include "diagnostics.h"
+
+// The string written by XGremlin in place of a value too large for its column
+#define XG_OVERLOAD "**********"
+#define XG_OVERLOAD_LEN 10
+
+using namespace::std;
+
+class RowTokenizer {
+  public:
+    RowTokenizer (const char *Begin, const char *End,
+      ParseDiagnostics *NewDiagnostics = NULL, unsigned int NewRow = 0)
+      { Position = Begin; RowEnd = End; Diagnostics = NewDiagnostics;
+        Row = NewRow; }
+
+    // GET functions for each field type. See the comments above for details of
+    // how errors are handled.
+    int getInt (const char *Column) throw (const char*);
+    double getDouble (const char *Column) throw (const char*);
+    char getChar (const char *Column) throw (const char*);
+    bool getFixed (string &Field, int Width, bool TrimRight = false);
+    bool getFixed (char *Field, int Width, bool TrimRight = false);
+
+    // Advances to the next non-whitespace character in the row
+    void skipSpace () {
+      while (Position < RowEnd && isSpace (*Position)) Position ++;
+    }
+
+  private:
+    const char *Position;
+    const char *RowEnd;
+    ParseDiagnostics *Diagnostics;
+    unsigned int Row;
+
+    static bool isSpace (char c) { return c == ' ' || (c >= '\t' && c <= '\r'); }
+    static bool isDigit (char c) { return c >= '0' && c <= '9'; }
+
+    // Called when a numeric field cannot be read. Skips an XG_OVERLOAD marker
+    // if one is present, or throws Column if not.
+    void checkOverload (const char *Column) throw (const char*);
+
+    // Converts a numeric string that lies outside the exact fast path in
+    // getDouble() using strtod(). Returns false if the value overflows.
+    static bool slowDouble (const char *Begin, const char *End, double &Value);
+};
+
+#endif // ROW_TOKENIZER_H
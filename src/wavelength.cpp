@@ -0,0 +1,126 @@
+// Xgtools
+// Copyright (C) M. P. Ruffoni 2011-2015
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// wavelength.cpp
+//==============================================================================
+
+#include "wavelength.h"
+#include <cstring>
+
+// On x86-64 with GCC, airWavelengths() is compiled once for each instruction
+// set below and the best chosen at run time. The AVX-512 version could
+// otherwise fuse the multiplications and subtractions into single
+// instructions, which round differently, so this is disabled to keep the
+// results identical. WL_LANES is the number of wavenumbers converted at once,
+// which is the width of an AVX-512 register. Narrower instruction sets process
+// the same vector in several parts.
+#if defined (__GNUC__) && !defined (__clang__) && defined (__x86_64__) \
+  && __GNUC__ >= 6
+#define WL_TARGET_CLONES \
+  __attribute__ ((target_clones ("avx512f", "avx2", "default"), \
+    optimize ("fp-contract=off")))
+#else
+#define WL_TARGET_CLONES
+#endif
+
+#if defined (__GNUC__) && !defined (__clang__) && __GNUC__ >= 5
+#define WL_LANES 8
+typedef double WlVector __attribute__ ((vector_size (WL_LANES * sizeof (double))));
+#endif
+
+
+//------------------------------------------------------------------------------
+// airWavelengths (const double *, size_t, double *, double *) : Converts the
+// arg2 wavenumbers at arg1 to vacuum wavelengths at arg3 and air wavelengths
+// at arg4. The whole vectors are converted first, and any remaining
+// wavenumbers one at a time. Both evaluate airRefractiveIndex() with the same
+// operations in the same order, so give identical results.
+//
+WL_TARGET_CLONES
+void airWavelengths (const double *Wavenumbers, size_t Count, double *Vacuum,
+  double *Air) {
+  size_t i = 0;
+#ifdef WL_LANES
+  WlVector Sigma, SigmaSquared, Lambda, Index;
+  for (; i + WL_LANES <= Count; i += WL_LANES) {
+    memcpy (&Sigma, Wavenumbers + i, sizeof (Sigma));
+    Lambda = 1.0e7 / Sigma;
+    Sigma = Sigma / 10000;
+    SigmaSquared = Sigma * Sigma;
+    Index = (8092.33 + 2333983 / (130 - SigmaSquared)
+      + (15518 / (38.9 - SigmaSquared))) / 1e8 + 1;
+    if (Vacuum) memcpy (Vacuum + i, &Lambda, sizeof (Lambda));
+    if (Air) {
+      Lambda = Lambda / Index;
+      memcpy (Air + i, &Lambda, sizeof (Lambda));
+    }
+  }
+#endif
+  for (; i < Count; i ++) {
+    double Lambda = 1.0e7 / Wavenumbers[i];
+    if (Vacuum) Vacuum[i] = Lambda;
+    if (Air) Air[i] = Lambda / airRefractiveIndex (Wavenumbers[i]);
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// WavelengthTable constructor : Creates a table written to the stream at arg1,
+// and buffers its column headings.
+//
+WavelengthTable::WavelengthTable (ostream &Output) : Buffer (Output) {
+  Buffer.print ("# %-28s  %12s  %12s  %12s\n", "Identification", 
+    "Wavenumber", "Vacuum (nm)", "Air (nm)");
+}
+
+
+//------------------------------------------------------------------------------
+// add (const string &, double) : Adds a line to the table, and converts and
+// writes the current block of lines once it is full.
+//
+bool WavelengthTable::add (const string &Id, double Wavenumber) {
+  Ids.push_back (Id);
+  Wavenumbers.push_back (Wavenumber);
+  if (Wavenumbers.size () < WL_BLOCK_SIZE) return true;
+  return flush ();
+}
+
+
+//------------------------------------------------------------------------------
+// flush () : Converts the wavenumbers of the current block of lines, writes a
+// table row for each, and empties the block.
+//
+bool WavelengthTable::flush () {
+  bool Written = true;
+  Vacuum.resize (Wavenumbers.size ());
+  Air.resize (Wavenumbers.size ());
+  if (!Wavenumbers.empty ()) {
+    airWavelengths (&Wavenumbers[0], Wavenumbers.size (), &Vacuum[0], &Air[0]);
+  }
+  for (unsigned int i = 0; i < Wavenumbers.size () && Written; i ++) {
+    if (Vacuum[i] >= WL_MIN_AIR_WAVELENGTH) {
+      Written = Buffer.print ("%-30.30s  %12.5f  %12.6f  %12.6f\n", 
+        Ids[i].c_str (), Wavenumbers[i], Vacuum[i], Air[i]);
+    } else {
+      Written = Buffer.print ("%-30.30s  %12.5f  %12.6f\n", 
+        Ids[i].c_str (), Wavenumbers[i], Vacuum[i]);
+    }
+  }
+  Ids.clear ();
+  Wavenumbers.clear ();
+  return Buffer.flush () && Written;
+}
@@ -0,0 +1,93 @@
+// Xgtools
+// Copyright (C) M. P. Ruffoni 2011-2015
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// wavelength.h
+//==============================================================================
+// Converts wavenumbers to vacuum and air wavelengths. airRefractiveIndex()
+// gives the refractive index of standard air from equation 6 of Bonsch, G., &
+// Potulski, E. 1998, Metrologia, 35, 133, and is used by XgLine to find the
+// air wavelength of a single line.
+//
+// airWavelengths() converts a whole array of wavenumbers at once. The formula
+// is evaluated on several wavenumbers at a time with GCC vector extensions, and
+// on x86-64 a copy of the function is compiled for each of AVX-512, AVX2 and
+// the baseline SSE2. The best of these for the processor in use is chosen when
+// the program starts. Other compilers and processors fall back to a plain
+// loop. Every version gives the same results as airRefractiveIndex().
+//
+// WavelengthTable uses airWavelengths() to write a table of the vacuum and air
+// wavelengths of every line in a list, as used for publication. Lines are
+// added one at a time, and converted and written in blocks of WL_BLOCK_SIZE,
+// so a list of any length is converted in constant memory. Air wavelengths
+// are conventionally only given above WL_MIN_AIR_WAVELENGTH, and the air
+// column is left blank for shorter wavelengths. The table begins with a
+// single comment row naming the columns.
+//
+#ifndef WAVELENGTH_H
+#define WAVELENGTH_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include "outputbuffer.h"
+
+// The number of lines converted at once by a WavelengthTable
+#define WL_BLOCK_SIZE 4096
+
+// The shortest vacuum wavelength, in nm, for which an air wavelength is given
+#define WL_MIN_AIR_WAVELENGTH 200.0
+
+using namespace::std;
+
+//------------------------------------------------------------------------------
+// airRefractiveIndex (double) : Returns the refractive index of air at the
+// wavenumber arg1, in cm^-1.
+//
+inline double airRefractiveIndex (double Wavenumber) {
+  double Sigma = Wavenumber / 10000;
+  double SigmaSquared = Sigma * Sigma;
+  return (8092.33 + 2333983 / (130 - SigmaSquared)
+    + (15518 / (38.9 - SigmaSquared))) / 1e8 + 1;
+}
+
+// Converts the arg2 wavenumbers at arg1, in cm^-1, to vacuum wavelengths at
+// arg3 and air wavelengths at arg4, both in nm. Either output may be NULL if
+// it is not needed. The outputs must not overlap the input.
+void airWavelengths (const double *Wavenumbers, size_t Count, double *Vacuum,
+  double *Air);
+
+class WavelengthTable {
+  public:
+    WavelengthTable (ostream &Output);
+    ~WavelengthTable () {}
+
+    // Adds the line with the identification at arg1 and wavenumber at arg2 to
+    // the table. Returns false if the table could not be written.
+    bool add (const string &Id, double Wavenumber);
+
+    // Converts and writes any lines not yet written. Returns false if the
+    // table could not be written.
+    bool flush ();
+
+  private:
+    OutputBuffer Buffer;
+    vector <string> Ids;
+    vector <double> Wavenumbers, Vacuum, Air;
+};
+
+#endif // WAVELENGTH_H
@@ -0,0 +1,40 @@
+// Xgtools
+// Copyright (C) M. P. Ruffoni 2011-2015
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//==============================================================================
+// writelinesheader.h
+//==============================================================================
+// The four header rows at the top of an XGremlin 'writelines' line list. A
+// WritelinesHeader is filled by readLineList() alongside the lines themselves,
+// and passed back to writeLines() so that the header can be copied to the
+// output line list. Each line list therefore carries its own header, and any
+// number of lists may be read at once, from any thread.
+//
+#ifndef WRITELINES_HEADER_H
+#define WRITELINES_HEADER_H
+
+#include <string>
+
+using namespace::std;
+
+typedef struct td_WritelinesHeader {
+  string WaveCorr;    // Wavenumber correction
+  string AirCorr;     // Air correction
+  string IntCal;      // Intensity calibration
+  string Columns;     // Column headings
+} WritelinesHeader;
+
+#endif // WRITELINES_HEADER_H
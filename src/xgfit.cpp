@@ -59,15 +59,6 @@ using namespace::std;
 #define XG_WAVCORR_OFFSET 33
 #define LIN_HEADER_SIZE 320 /* bytes */
 
-// A namespace to store the header from the XGremlin writelines file. This can
-// then be used to copy the header to the output line list in writeLines().
-namespace writelines_header {
-  string WaveCorr;
-  string AirCorr;
-  string IntCal;
-  string Columns;
-}
-
 // In XGremlin's lineio.f, the layout of a .lin file record is explained:
 // 
 //"* variable    type           size/bytes
@@ -111,7 +102,8 @@ void load_spectrum (char *Filename, vector <string> &Script);
 void fit_lines (int Iterations, vector <bool> Drop, vector <string> &Script);
 void write_lines (vector <string> &Script);
 void run_xg_script (vector <string> &Script) throw (string);
-//void readLineList (string Filename, vector <Line> *Lines) throw (int);
+//void readLineList (string Filename, vector <Line> *Lines,
+//  WritelinesHeader *Header) throw (int);
 vector <XgLine> readLinFile (string LinFile) throw (int);
 void testArguments (int argc, char *argv[]) throw (string);
 void showHelp ();
@@ -153,12 +145,27 @@ int main (int argc, char *argv[]) {
   
   // Load the initial line fit results into InitialLines and prepare the list
   // of dropped lines.
-//  readLineList (TEMP_LINES, &InitialLines);
+//  readLineList (TEMP_LINES, &InitialLines, &ListHeader);
   InitialLines = readLinFile (string(argv[1]) + ".lin");
   for (unsigned int i = 0; i < InitialLines.size (); i ++) {
     Drop.push_back (false);
   }
   
+  // Report the memory saved by holding the line strings in the XgLine string
+  // pool, rather than as three separate strings in every line.
+  size_t UnpooledBytes = 0;
+  for (unsigned int i = 0; i < InitialLines.size (); i ++) {
+    UnpooledBytes += StringPool::stringBytes (InitialLines[i].tags ())
+      + StringPool::stringBytes (InitialLines[i].id ())
+      + StringPool::stringBytes (InitialLines[i].name ())
+      - 3 * sizeof (StringPool::Handle);
+  }
+  size_t PooledBytes = XgLine::stringPool ().bytes ();
+  cout << "Loaded " << InitialLines.size () << " lines with "
+    << XgLine::stringPool ().size () << " distinct strings (" 
+    << (UnpooledBytes > PooledBytes ? UnpooledBytes - PooledBytes : 0) / 1024
+    << " KiB saved by string pooling)" << endl;
+  
   // Now iterate, performing multiple calls to lsqfit and checking the results
   // each time. Drop any lines for which the fit parameters begin to differ
   // significantly from those in InitialLines.
@@ -178,7 +185,7 @@ int main (int argc, char *argv[]) {
     cout << "Iterations done: " << IterationsDone << endl;
     
     FitIncomplete = false;
-//    readLineList (TEMP_LINES, &FittedLines);
+//    readLineList (TEMP_LINES, &FittedLines, &ListHeader);
     FittedLines = readLinFile (string(argv[1]) + ".lin");
     for (unsigned int i = 0; i < FittedLines.size (); i ++) {
       if (FittedLines [i].itn () == IterationsDone + 1) {
@@ -270,13 +277,15 @@ void showHelp () {
 
 
 //------------------------------------------------------------------------------
-// readLineList (string, vector <Line>) : Opens and reads an XGremlin writelines
-// line list. The string from each individual row in the ascii file is passed to
-// the Line object constructor, which extracts the line parameters. The
-// resulting Line object is added to the Line vector at arg2, which, being 
-// passed in by reference, is returned to the calling function.
+// readLineList (string, vector <Line> *, WritelinesHeader *) : Opens and reads
+// an XGremlin writelines line list. The string from each individual row in the
+// ascii file is passed to the Line object constructor, which extracts the line
+// parameters. The resulting Line object is added to the Line vector at arg2,
+// and the header rows are stored in arg3. Being passed in by reference, both
+// are returned to the calling function.
 //
-/*void readLineList (string Filename, vector <Line> *Lines) throw (int) {
+/*void readLineList (string Filename, vector <Line> *Lines, 
+  WritelinesHeader *Header) throw (int) {
   string LineString;
   double WavCorr = 0.0;
   unsigned int LineCount = XG_WRITELINES_HEADER_LENGTH;
@@ -290,13 +299,13 @@ void showHelp () {
   
   // Extract the data from the line list header
   try {
-    getline (ListFile, writelines_header::WaveCorr); // wavenumber correction
+    getline (ListFile, Header -> WaveCorr); // wavenumber correction
     if (ListFile.fail()) throw(" wavenumber correction ");
-    getline (ListFile, writelines_header::AirCorr);  // air correction
+    getline (ListFile, Header -> AirCorr);  // air correction
     if (ListFile.fail()) throw("  air correction ");
-    getline (ListFile, writelines_header::IntCal);   // intensity calibration
+    getline (ListFile, Header -> IntCal);   // intensity calibration
     if (ListFile.fail()) throw(" intensity calibration ");
-    getline (ListFile, writelines_header::Columns);  // column headers
+    getline (ListFile, Header -> Columns);  // column headers
     if (ListFile.fail()) throw(" column headers ");
   } catch (const char* Line) {
     cout << "Error reading" << Line << "from the " << Filename << " header.\n"
@@ -337,6 +346,7 @@ vector <XgLine> readLinFile (string LinFile) throw (int) {
   LineIn NextLineIn;
   XgLine NextLine;
   vector <XgLine> RtnLines;
+  string Id;
 //  VoigtLsqfit V;
   
   LinIn.open (LinFile.c_str (), ios::in|ios::binary);
@@ -352,7 +362,9 @@ vector <XgLine> readLinFile (string LinFile) throw (int) {
   LinIn.read ((char*)&SigCorrection, sizeof (float));
   
   // Move to the location of the first line then extract all the line records.
+  // Every line has the same source filename, so this is set just once.
   LinIn.seekg (LIN_HEADER_SIZE, ios::beg);
+  NextLine.name (LinFile.substr (LinFile.find_last_of ("/\\") + 1));
   for (int i = 0; i < NumLines; i ++) {
     LinIn.read ((char*)&NextLineIn, sizeof (LineIn));
     if (LinIn.good ()) {
@@ -368,9 +380,8 @@ vector <XgLine> readLinFile (string LinFile) throw (int) {
       NextLine.epsevn (NextLineIn.epsevn);
       NextLine.epsodd (NextLineIn.epsodd);
       NextLine.epsran (NextLineIn.epsran);
-      NextLine.id (string (NextLineIn.id));
-      NextLine.id (NextLine.id().substr (0, NextLine.id().length () - 4));
-      NextLine.name (LinFile.substr (LinFile.find_last_of ("/\\") + 1));
+      Id = NextLineIn.id;
+      NextLine.id (Id.substr (0, Id.length () - 4));
       
       // Calculate the equivalent width of the line using XGremlin's mystical
       // "p" array, as shown in subroutine wrtlin in lineio.f
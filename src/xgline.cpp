@@ -19,11 +19,46 @@
 //==============================================================================
 
 #include "xgline.h"
+#include "tokenizer.h"
+#include "recordlayout.h"
+#include "wavelength.h"
 #include <iostream>
 #include <sstream>
 #include <cmath>
 
-#define XG_OVERLOAD "**********"
+// Field macros for the writelines tags and identification, which are pooled
+// strings in an XgLine, and must both be present. Each is read into a buffer
+// on the stack, and only then interned into the line's pool. See
+// recordlayout.h.
+#define XGLINE_TAG_FORMAT(Column, Member, Get, Width, Read) "%" #Width "s"
+#define XGLINE_TAG_ARG(Column, Member, Get, Width, Read)                       \
+  , Pool -> get (Member).c_str ()
+#define XGLINE_TAG_READ(Column, Member, Get, Width, Read)                      \
+  { char Field [Read + 1];                                                     \
+    if (!Row.getFixed (Field, Read)) throw (#Column);                          \
+    Member = Pool -> intern (Field); }
+#define XGLINE_TEXT_ARG(Column, Member, Spec, Read)                            \
+  , Pool -> get (Member).c_str ()
+#define XGLINE_TEXT_READ(Column, Member, Spec, Read)                           \
+  { char Field [Read + 1];                                                     \
+    if (!Row.getFixed (Field, Read, true)) throw (#Column);                    \
+    Member = Pool -> intern (Field); }
+
+// printf() formats and arguments for the output strings, generated from the
+// 'syn' and 'writelines' layouts in recordlayout.h.
+#define LINE_SYN_FORMAT                                                        \
+  SYN_LAYOUT (LAYOUT_REAL_FORMAT, LAYOUT_TEXT_FORMAT, LAYOUT_GAP_FORMAT)
+#define LINE_SYN_ARGS                                                          \
+  SYN_LAYOUT (LAYOUT_REAL_ARG, XGLINE_TEXT_ARG, LAYOUT_NONE)
+#define LINE_STRING_FORMAT                                                     \
+  WRITELINES_LAYOUT (LAYOUT_INT_FORMAT, LAYOUT_REAL_FORMAT, XGLINE_TAG_FORMAT, \
+    LAYOUT_TEXT_FORMAT, LAYOUT_GAP_FORMAT)
+#define LINE_STRING_ARGS                                                       \
+  WRITELINES_LAYOUT (LAYOUT_INT_ARG, LAYOUT_REAL_ARG, XGLINE_TAG_ARG,          \
+    XGLINE_TEXT_ARG, LAYOUT_NONE)
+
+// The pool holding the tags, identification and source filename of every XgLine
+StringPool XgLine::Strings;
 
 //------------------------------------------------------------------------------
 // Default Line constructor : Sets all the line properties to default values
@@ -31,10 +66,11 @@
 XgLine::XgLine () {
   Index = 0; Itn = 0; H = 0; Wavenumber = 0.0; Peak = 0.0;  Width = 0.0; 
   Dmp = 0.0; EqWidth = 0.0; EpsTot = 0.0; EpsEvn = 0.0; EpsOdd = 0.0; 
-  EpsRan = 0.0; Wavelength = 0.0; Tags = ""; Identification = "";
+  EpsRan = 0.0; Wavelength = 0.0; Tags = SP_EMPTY; Identification = SP_EMPTY;
   WavenumberCorrection = 0.0; AirCorrection = 0.0; IntensityCalibration = 0.0;
   SNR = 0.0;
-  SourceFilename = "";
+  SourceFilename = SP_EMPTY;
+  Pool = &Strings;
   CustomSNR = false;
 }
 
@@ -49,117 +85,52 @@ XgLine::XgLine (string LineData, double NewWaveCorr, double NewAirCorr,
   WavenumberCorrection = NewWaveCorr;
   AirCorrection = NewAirCorr;
   IntensityCalibration = NewIntCal;
+  SourceFilename = SP_EMPTY;
+  Pool = &Strings;
   createLine (LineData);
 }
 
 
-//------------------------------------------------------------------------------
-// Line = operator : Copies the operator Line into the current class instance
-//
-void XgLine::operator= (XgLine Operator) {
-  Index = Operator.line ();
-  Itn = Operator.itn ();
-  H = Operator.h ();
-  Wavenumber = Operator.wavenumber ();
-  Peak = Operator.peak ();
-  Width = Operator.width ();
-  Dmp = Operator.dmp ();
-  EqWidth = Operator.eqwidth ();
-  EpsTot = Operator.epstot ();
-  EpsEvn = Operator.epsevn ();
-  EpsOdd = Operator.epsodd ();
-  EpsRan = Operator.epsran ();
-  Wavelength = Operator.wavelength ();
-  Tags = Operator.tags ();
-  Identification = Operator.id ();
-  WavenumberCorrection = Operator.wavCorr ();
-  AirCorrection = Operator.airCorrection ();
-  IntensityCalibration = Operator.intensityCalibration ();
-  SourceFilename = Operator.name ();
-}
-
-
 //------------------------------------------------------------------------------
 // airWavelength () : Returns this XgLines's air wavelength, which is calculated
-// from equation 6 in Bonsch, G., & Potulski, E. 1998, Metrologia, 35, 133.
+// from equation 6 in Bonsch, G., & Potulski, E. 1998, Metrologia, 35, 133. See
+// wavelength.h, which also converts whole lists of wavenumbers at once.
 //
-double XgLine::airWavelength () {
-  double RefractiveIndex, AirWavelength;
-  
-  RefractiveIndex = (8092.33 + 2333983 / (130 - pow (wavenumber () / 10000, 2))
-    + (15518 / (38.9 - pow (wavenumber () / 10000, 2)))) / 1e8 + 1;
-  AirWavelength = wavelength () / RefractiveIndex;
-  return AirWavelength;
+double XgLine::airWavelength () const {
+  return wavelength () / airRefractiveIndex (wavenumber ());
 }
 
 
 //------------------------------------------------------------------------------
-// checkInput (isstringstream &, const char *) : If a read error occurs in the
-// createLine function below, checkInput is called to examine the failed input.
-// If the error was caused by XGremlin writing ********** in a column rather
-// than a real value, a warning is printed and input is allowed to continue. Any
-// other error will cause an exception to be thrown.
+// createLine (string) : Creates a Line from an XGremlin "writelines" string
 //
-void XgLine::checkInput (istringstream &iss, const char* Err) throw (const char *) {
-  iss.clear ();
-  string TestInput;
-  iss >> TestInput;
-  if (TestInput == XG_OVERLOAD) {
-    cout << "Warning: " << XG_OVERLOAD << " has been found in the " << Err
-      << " column. A value of zero has been taken instead." << endl;
-    return;
-  } else {
-    throw Err;
-  }
+void XgLine::createLine (string LineString) throw (const char*) {
+  createLine (LineString.data (), LineString.data () + LineString.size ());
 }
 
 
 //------------------------------------------------------------------------------
-// createLine (string) : Creates a Line from an XGremlin "writelines" string
+// createLine (const char *, const char *, ParseDiagnostics *, unsigned int) :
+// Creates a Line from the XGremlin "writelines" row held in the character range
+// [arg1, arg2). Any overloads are recorded in arg3 as being in row arg4.
 //
-void XgLine::createLine (string LineString) throw (const char*) {
-  istringstream iss;
-  iss.str (LineString);
-  char IdCharString [LINE_ID_STRING_LEN], TagCharString [LINE_TAG_STRING_LEN];
-
-  // Read the contents of the Line string
-  iss >> skipws >> Index; if (iss.fail ()) { Index = 0; checkInput (iss, "index"); }
-  iss >> Wavenumber; if (iss.fail ()) { Wavenumber = 0.0; checkInput (iss, "wavenumber"); }
-  iss >> Peak; if (iss.fail ()) { Peak = 0.0; checkInput (iss, "peak height"); }
-  iss >> Width; if (iss.fail ()) { Width = 0.0; checkInput (iss, "width"); }
-  iss >> Dmp; if (iss.fail ()) { Dmp = 0.0; checkInput (iss, "dmp"); }
-  iss >> EqWidth; if (iss.fail ()) { EqWidth = 0.0; checkInput (iss, "eqwidth"); }
-  iss >> Itn; if (iss.fail ()) { Itn = 0; checkInput (iss, "itn"); }
-  iss >> H; if (iss.fail ()) { H = 0; checkInput (iss, "h"); }
-  iss >> ws;
+void XgLine::createLine (const char *Begin, const char *End,
+  ParseDiagnostics *Diagnostics, unsigned int RowNum) throw (const char*) {
+  RowTokenizer Row (Begin, End, Diagnostics, RowNum);
+
+  // Read the contents of the Line string, one field at a time as listed in
+  // WRITELINES_LAYOUT. The tags and line id are read as fixed length strings as
+  // they may contain spaces. Any whitespace at the end of the ID is removed.
+  WRITELINES_LAYOUT (LAYOUT_INT_READ, LAYOUT_REAL_READ, XGLINE_TAG_READ,
+    XGLINE_TEXT_READ, LAYOUT_NONE)
   
-  // Read the tags as a fixed length string as it may contain spaces
-  iss.get (TagCharString, LINE_TAG_STRING_LEN); if (iss.fail ()) throw ("tags");
-  Tags = TagCharString;
-
-  iss >> skipws;  
-  iss >> EpsTot; if (iss.fail ()) { EpsTot = 0.0; checkInput (iss, "epstot"); }
-  iss >> EpsEvn; if (iss.fail ()) { EpsEvn = 0.0; checkInput (iss, "epsevn"); }
-  iss >> EpsOdd; if (iss.fail ()) { EpsOdd = 0.0; checkInput (iss, "epsodd"); }
-  iss >> EpsRan; if (iss.fail ()) { EpsRan = 0.0; checkInput (iss, "epsran"); }
-  iss >> ws;
-  
-  // Read the line id as a fixed length string as it may contain spaces
-  iss.get (IdCharString, LINE_ID_STRING_LEN); if (iss.fail ()) throw ("id");
-  Identification = IdCharString;
-
-  iss >> Wavelength; if (iss.fail ()) { Wavelength = 0.0; checkInput (iss, "wavelength"); }
-
-  // Remove whitespace at the end of the ID string
-  for (int i = Identification.length () - 1; i >= 0; i --) {
-    if (Identification [i] == ' ') Identification.erase (i);
-    else break;
+  // Finally, remove any wavenumber correction from the internally stored params.
+  // Division by one changes nothing, so this is skipped when there is none.
+  if (WavenumberCorrection != 0.0) {
+    Wavenumber /= 1.0 + WavenumberCorrection;
+    Width /= 1.0 + WavenumberCorrection;
+    Wavelength *= 1.0 + WavenumberCorrection;
   }
-  
-  // Finally,remove the wavenumber correction from the internally stored params.
-  Wavenumber /= 1.0 + WavenumberCorrection;
-  Width /= 1.0 + WavenumberCorrection;
-  Wavelength *= 1.0 + WavenumberCorrection;
 }
 
 
@@ -169,7 +140,7 @@ void XgLine::createLine (string LineString) throw (const char*) {
 // std::cout by default.
 //
 void XgLine::print (ostream& Output) {
-  Output << "Line " << Index << " (" << Identification << "):" << endl;
+  Output << "Line " << Index << " (" << id () << "):" << endl;
   Output.precision (6);
   Output << " Wavenumber : " << fixed << Wavenumber << endl;
   Output.precision (4);
@@ -181,7 +152,7 @@ void XgLine::print (ostream& Output) {
   Output << " EqWidth    : " << scientific << EqWidth << endl;
   Output << " Itn        : " << Itn << endl;
   Output << " H          : " << H << endl;
-  Output << " Tags       : " << Tags << endl;
+  Output << " Tags       : " << tags () << endl;
   Output.precision (5);
   Output << " Residuals  : total = " << EpsTot << ", even = " << EpsEvn <<
     ", odd = " << EpsOdd << ", random = " << EpsRan << endl;
@@ -194,14 +165,10 @@ void XgLine::print (ostream& Output) {
 // getLineSynString () : Returns the line properties in a formatted string for 
 // use with XGremlin's readlines command in 'syn' mode. 
 //
-string XgLine::getLineSynString () {
-  ostringstream oss;
-  oss.width (15); oss << left << Identification << "  ";
-  oss.width (12); oss.precision (5); oss << fixed << right << wavenumber ();
-  oss.width (10); oss.precision (4); oss << right << peak ();
-  oss.width (9);  oss.precision (2); oss << right << width ();
-  oss.width (8);  oss.precision (4); oss << right << dmp ();
-  return oss.str();
+string XgLine::getLineSynString () const {
+  OutputBuffer Buffer;
+  Buffer.print (LINE_SYN_FORMAT LINE_SYN_ARGS);
+  return Buffer.str ();
 }
 
 
@@ -209,26 +176,28 @@ string XgLine::getLineSynString () {
 // getLineString () : Returns the line properties in a formatted string matching
 // the XGremlin writelines file format.
 //
-string XgLine::getLineString () {
-  string IdLong = id();
-  IdLong.resize (LINE_ID_STRING_LEN, ' ');
-  ostringstream oss;
-  oss.width (6);  oss << right << Index << "  ";
-  oss.width (12); oss.precision (6); oss << fixed << right << wavenumber ();
-  oss.width (10); oss.precision (3); oss << scientific << right << peak ();
-  oss.width (9);  oss.precision (2); oss << fixed << right << width ();
-  oss.width (9);  oss.precision (4); oss << fixed << right << dmp ();
-  oss.width (11); oss.precision (4); oss << scientific << right << eqwidth ();
-  oss.width (6); oss << right << itn ();
-  oss.width (4); oss << right << h ();
-  oss.width (5); oss << right << tags ();
-  oss.width (11); oss.precision (4); oss << scientific << right << epstot ();
-  oss.width (11); oss.precision (4); oss << scientific << right << epsevn ();
-  oss.width (11); oss.precision (4); oss << scientific << right << epsodd ();
-  oss.width (11); oss.precision (4); oss << scientific << right << epsran ();
-  oss << left << " " << IdLong;
-  oss.width (11); oss.precision (6); oss << fixed << right << wavelength ();
-  return oss.str();
+string XgLine::getLineString () const {
+  OutputBuffer Buffer;
+  Buffer.print (LINE_STRING_FORMAT LINE_STRING_ARGS);
+  return Buffer.str ();
+}
+
+
+//------------------------------------------------------------------------------
+// writeLineSynString (OutputBuffer &) : Appends the 'syn' string returned by
+// getLineSynString() to the buffer at arg1, followed by a newline.
+//
+bool XgLine::writeLineSynString (OutputBuffer &Buffer) const {
+  return Buffer.print (LINE_SYN_FORMAT "\n" LINE_SYN_ARGS);
+}
+
+
+//------------------------------------------------------------------------------
+// writeLineString (OutputBuffer &) : Appends the writelines string returned by
+// getLineString() to the buffer at arg1, followed by a newline.
+//
+bool XgLine::writeLineString (OutputBuffer &Buffer) const {
+  return Buffer.print (LINE_STRING_FORMAT "\n" LINE_STRING_ARGS);
 }
 
 
@@ -285,7 +254,7 @@ void XgLine::wavelength (double NewWavelength) throw (Error) {
 //------------------------------------------------------------------------------
 // Complex line GET functions. Implementation of simple functions is in line.h.
 //
-double XgLine::snr () {
+double XgLine::snr () const {
   if (CustomSNR) {
     return SNR;
   } else {
@@ -320,29 +289,17 @@ void XgLine::save (ofstream &BinOut)
   BinOut.write ((char*)&AirCorrection, sizeof (double));
   BinOut.write ((char*)&IntensityCalibration, sizeof (double));
   
-  Size = Tags.size ();
-  char tags [Size];
-  for (int i = 0; i < Size; i ++) {
-    tags[i] = Tags[i];
-  }
+  Size = Pool -> get (Tags).size ();
   BinOut.write ((char*)&Size, sizeof (int));
-  BinOut.write ((char*)&tags, sizeof (char) * Size);
+  BinOut.write (Pool -> get (Tags).data (), sizeof (char) * Size);
 
-  Size = Identification.size ();
-  char id [Size];
-  for (int i = 0; i < Size; i ++) {
-    id[i] = Identification[i];
-  }
+  Size = Pool -> get (Identification).size ();
   BinOut.write ((char*)&Size, sizeof (int));
-  BinOut.write ((char*)&id, sizeof (char) * Size);
+  BinOut.write (Pool -> get (Identification).data (), sizeof (char) * Size);
 
-  Size = SourceFilename.size ();
-  char name [Size];
-  for (int i = 0; i < Size; i ++) {
-    name[i] = SourceFilename[i];
-  }
+  Size = Pool -> get (SourceFilename).size ();
   BinOut.write ((char*)&Size, sizeof (int));
-  BinOut.write ((char*)&name, sizeof (char) * Size);
+  BinOut.write (Pool -> get (SourceFilename).data (), sizeof (char) * Size);
 }
 
 
@@ -372,19 +329,19 @@ void XgLine::load (ifstream &BinIn)
   char tags [Size + 1];
   BinIn.read ((char*)&tags, sizeof (char) * Size);
   tags [Size] = '\0';
-  Tags = string (tags);
+  Tags = Pool -> intern (tags);
   
   BinIn.read ((char*)&Size, sizeof (int));
   char id [Size + 1];
   BinIn.read ((char*)&id, sizeof (char) * Size);
   id [Size] = '\0';
-  Identification = string (id);
+  Identification = Pool -> intern (id);
   
   BinIn.read ((char*)&Size, sizeof (int));
   char name [Size + 1];
   BinIn.read ((char*)&name, sizeof (char) * Size);
   name [Size] = '\0';
-  SourceFilename = string (name);
+  SourceFilename = Pool -> intern (name);
   
 }    
   
@@ -401,3 +358,23 @@ void XgLine::load (ifstream &BinIn)
   
   
   
+
+
+//------------------------------------------------------------------------------
+// ChunkStrings <XgLine>::merge (vector <XgLine> *, unsigned int, unsigned int) :
+// Adds the strings of this chunk to the shared pool, then replaces the handles
+// into the chunk's pool held by lines [arg2, arg3) of the vector at arg1 with
+// the matching handles into the shared pool, and points the lines to it.
+//
+void ChunkStrings <XgLine>::merge (vector <XgLine> *Lines, unsigned int First,
+  unsigned int Last) throw (Error) {
+  vector <StringPool::Handle> Handles;
+  XgLine::Strings.merge (Local, &Handles);
+  for (unsigned int i = First; i < Last; i ++) {
+    XgLine &NextLine = (*Lines)[i];
+    NextLine.Tags = Handles [NextLine.Tags];
+    NextLine.Identification = Handles [NextLine.Identification];
+    NextLine.SourceFilename = Handles [NextLine.SourceFilename];
+    NextLine.Pool = &XgLine::Strings;
+  }
+}
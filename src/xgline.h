@@ -49,6 +49,21 @@
 // XGremlin, and so must be passed in at arg1. A default spacing is given by
 // DEF_POINT_SPACING.
 //
+// The tags, identification and source filename of a line are interned in a
+// StringPool, which by default is shared by every XgLine, so a list in which
+// thousands of lines have the same source filename stores that filename only
+// once. Each line holds only a 32-bit handle to each string, and a pointer to
+// the pool holding them, which is copied with the line. The shared pool can be
+// examined with stringPool(), for example to report the memory it has saved.
+//
+// Lines may instead be created in a pool of their own through the ChunkStrings
+// <XgLine> specialisation below (see chunkparse.h). When a list is parsed in
+// chunks by parseLineRows(), each chunk interns its strings into a pool local
+// to the chunk, and these are merged into the shared pool once the chunk has
+// been parsed, so the parsing threads never wait on the shared pool's lock.
+// LineListReader clears its pool before each row instead, so reading a list
+// one line at a time never adds its strings to the shared pool at all.
+//
 #ifndef XG_LINE_H
 #define XG_LINE_H
 
@@ -57,6 +72,10 @@
 #include <fstream>
 #include <string>
 #include "ErrDefs.h"
+#include "outputbuffer.h"
+#include "diagnostics.h"
+#include "stringpool.h"
+#include "chunkparse.h"
 
 // The default spacing between spectru data points, in cm^-1. This is used by
 // getCentroidError() when calculating the Brault line centre error.
@@ -81,28 +100,28 @@ class XgLine {
   
     // GET functions to access line properties. Apply the wavenumber correction
     // factor to any properties that require it.
-    int line () { return Index; }
-    int itn () { return Itn; }
-    int h () { return H; }
-    double wavenumber () { return Wavenumber * (1.0 + WavenumberCorrection); }
-    double peak () { return Peak; }
-    double snr ();
-    double width () { return Width * (1.0 + WavenumberCorrection); }
-    double dmp () { return Dmp; }
-    double eqwidth () { return EqWidth; }
-    double epstot () { return EpsTot; }
-    double epsevn () { return EpsEvn; }
-    double epsodd () { return EpsOdd; }
-    double epsran () { return EpsRan; }
-    double spare () { return Spare; }
-    double wavelength () { return 1.0e7 / wavenumber (); }
-    double airWavelength ();
-    string tags () { return Tags; }
-    string id () { return Identification; }
-    double wavCorr () { return WavenumberCorrection; }
-    double airCorrection () { return AirCorrection; }
-    double intensityCalibration () { return IntensityCalibration; }
-    string name () { return SourceFilename; }
+    int line () const { return Index; }
+    int itn () const { return Itn; }
+    int h () const { return H; }
+    double wavenumber () const { return Wavenumber * (1.0 + WavenumberCorrection); }
+    double peak () const { return Peak; }
+    double snr () const;
+    double width () const { return Width * (1.0 + WavenumberCorrection); }
+    double dmp () const { return Dmp; }
+    double eqwidth () const { return EqWidth; }
+    double epstot () const { return EpsTot; }
+    double epsevn () const { return EpsEvn; }
+    double epsodd () const { return EpsOdd; }
+    double epsran () const { return EpsRan; }
+    double spare () const { return Spare; }
+    double wavelength () const { return 1.0e7 / wavenumber (); }
+    double airWavelength () const;
+    const string &tags () const { return Pool -> get (Tags); }
+    const string &id () const { return Pool -> get (Identification); }
+    double wavCorr () const { return WavenumberCorrection; }
+    double airCorrection () const { return AirCorrection; }
+    double intensityCalibration () const { return IntensityCalibration; }
+    const string &name () const { return Pool -> get (SourceFilename); }
     
     // SET functions to modify line properties
     void line (int NewIndex) { Index = NewIndex; }
@@ -120,32 +139,48 @@ class XgLine {
     void epsran (double NewEpsran) { EpsRan = NewEpsran; }
     void spare (double NewSpare) { Spare = NewSpare; }
     void wavelength (double NewWavelength) throw (Error);
-    void tags (string NewTags) { Tags = NewTags; }
-    void id (string NewId) { Identification = NewId; }
+    void tags (const string &NewTags) { Tags = Pool -> intern (NewTags); }
+    void id (const string &NewId) { Identification = Pool -> intern (NewId); }
     void wavCorr (double NewCorr){ WavenumberCorrection = NewCorr;}
     void airCorrection (double NewCorrection) { AirCorrection = NewCorrection; }
     void intensityCalibration (double NewCal) { IntensityCalibration = NewCal; }
-    void name (string NewName) { SourceFilename = NewName; }
+    void name (const string &NewName)
+      { SourceFilename = Pool -> intern (NewName); }
 
     // Allow the user to create a Line from a string read from an XGremlin
-    // "writelines" output file.
+    // "writelines" output file. The second form reads the line directly from
+    // the characters in [Begin, End), such as a row of a memory-mapped file,
+    // without copying them. Any overloads in the row are recorded in
+    // Diagnostics, if given, as being in row Row of the file.
     void createLine (string LineString) throw (const char*);
+    void createLine (const char *Begin, const char *End,
+      ParseDiagnostics *Diagnostics = NULL, unsigned int Row = 0)
+      throw (const char*);
     
-    // An = operator to copy the contents of one line to another.
-    void operator= (XgLine Operator);
+    // XgLine is copied and assigned member by member by the compiler-generated
+    // functions, so a copy keeps the uncorrected properties and the wavenumber
+    // correction of the original.
     
     // Output functions. print (...) writes the line properties to a specified
     // stream or to std::cout by default. getLineSynString() and getLineString()
     // return the line properties in a format matching XGremlin's 'syn' and 
     // 'old' formats. See 'readlines' in the XGremlin manual for more info.
+    // writeLineSynString() and writeLineString() append the same strings,
+    // followed by a newline, to an OutputBuffer, and return false if the buffer
+    // could not be written out.
     void print (ostream& Output = std::cout);
-    string getLineSynString ();
-    string getLineString ();
+    string getLineSynString () const;
+    string getLineString () const;
+    bool writeLineSynString (OutputBuffer &Buffer) const;
+    bool writeLineString (OutputBuffer &Buffer) const;
     void save (ofstream& BinOut);
     void load (ifstream& BinIn);
     
     // Calculates the error in the line centroid position using the Brault eqn.
     double getCentroidError (double PointsInFwhm = DEF_POINT_SPACING);
+
+    // Returns the pool shared by every XgLine not created through ChunkStrings
+    static const StringPool &stringPool () { return Strings; }
    
   private:
     // Line properties. Follows the naming convention used in the XGremlin
@@ -153,7 +188,8 @@ class XgLine {
     int Index, Itn, H;
     double Wavenumber, Peak, Width, Dmp, EqWidth, EpsTot, 
       EpsEvn, EpsOdd, EpsRan, Wavelength, SNR;
-    string Tags, Identification, SourceFilename;
+    StringPool::Handle Tags, Identification, SourceFilename;
+    StringPool *Pool;
     double Spare;
     bool CustomSNR;
     
@@ -161,11 +197,29 @@ class XgLine {
     double WavenumberCorrection;
     double AirCorrection;
     double IntensityCalibration;
-    
-    // If an error is thrown while reading an XGremlin writelines file, check
-    // the nature of the error for known problems. If these can be handled, fix
-    // the problem. If not, continue to throw the error.
-    void checkInput (istringstream &iss, const char* Err) throw (const char *);
+
+    static StringPool Strings;
+
+    friend class ChunkStrings <XgLine>;
+};
+
+// Creates XgLines whose strings are interned into a pool local to this object.
+// merge() adds these strings to the pool shared by every XgLine, and points the
+// lines to them, while clear() discards them, along with the strings of every
+// line created so far.
+template <>
+class ChunkStrings <XgLine> {
+  public:
+    void createLine (XgLine &NewLine, const char *Begin, const char *End,
+      ParseDiagnostics *Diagnostics, unsigned int Row) throw (const char*)
+      { NewLine.Pool = &Local;
+        NewLine.createLine (Begin, End, Diagnostics, Row); }
+    void merge (vector <XgLine> *Lines, unsigned int First,
+      unsigned int Last) throw (Error);
+    void clear () { Local.clear (); }
+
+  private:
+    StringPool Local;
 };
     
 #endif // XG_LINE_H